@@ -0,0 +1,134 @@
+// Counts heap allocations per hop in a steady-state pipeline.
+// main -> Stage-1 -> Stage-2 -> Stage-3 (sink), with null, shared and inline typed payloads.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "ThreadWrapper/ThreadWrapperApp.hpp"
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static constexpr int STAGES = 3;
+static constexpr uint64_t WARMUP_MESSAGES = 10000;
+static constexpr uint64_t MEASURED_MESSAGES = 200000;
+
+static std::atomic<uint64_t> g_delivered{0};
+
+class ForwardStage : public ThreadWrapper {
+public:
+    explicit ForwardStage(std::string next_name) : next_name_(std::move(next_name)) {}
+
+    ThreadWrapperError initialize() override
+    {
+        if (!next_name_.empty()) {
+            next_id_ = get_thread_wrapper_id_by_name(next_name_);
+        }
+        return ThreadWrapperError::OK;
+    }
+
+    // Forwards the whole envelope, so inline payloads are never boxed.
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        if (next_id_ == INVALID_INSTANCE_ID) {
+            g_delivered.fetch_add(1, std::memory_order_relaxed);
+            return ThreadWrapperError::OK;
+        }
+        return get_thread_wrapper_app_instance().send_envelope_wait(
+            next_id_, std::move(msg), std::chrono::steady_clock::time_point::max());
+    }
+
+private:
+    std::string next_name_;
+    int next_id_ = INVALID_INSTANCE_ID;
+};
+
+// Small trivially copyable payload, carried inline in the envelope by send<T>().
+struct Sample {
+    uint64_t sequence;
+    double value;
+};
+
+enum class PayloadMode { NONE, SHARED, INLINE };
+
+static void pump(int first_id, PayloadMode mode, uint64_t count)
+{
+    auto& app = get_thread_wrapper_app_instance();
+    static const std::shared_ptr<void> shared_payload = std::make_shared<uint64_t>(42);
+
+    uint64_t target = g_delivered.load() + count;
+    for (uint64_t i = 0; i < count; ++i) {
+        switch (mode) {
+            case PayloadMode::NONE:   send_message_wait(first_id, 1, nullptr); break;
+            case PayloadMode::SHARED: send_message_wait(first_id, 1, shared_payload); break;
+            case PayloadMode::INLINE: app.send_wait(first_id, 1, Sample{i, 1.0}); break;
+        }
+    }
+    while (g_delivered.load() < target) {
+        std::this_thread::yield();
+    }
+}
+
+static std::string stage_name(const char* prefix, int index)
+{
+    return std::string(prefix) + "-Stage-" + std::to_string(index);
+}
+
+int main()
+{
+    auto& app = get_thread_wrapper_app_instance();
+
+    const MailboxType types[] = {MailboxType::LOCK_FREE, MailboxType::MUTEX};
+    const char* type_names[] = {"lock_free", "mutex"};
+    const PayloadMode payloads[] = {PayloadMode::NONE, PayloadMode::SHARED, PayloadMode::INLINE};
+    const char* payload_names[] = {"null", "shared", "inline"};
+
+    printf("%-10s %-10s %12s %14s %18s\n", "mailbox", "payload", "messages", "allocations", "allocs/msg/hop");
+    for (int t = 0; t < 2; ++t) {
+        std::vector<ThreadWrapperParam> params;
+        for (int i = 1; i <= STAGES; ++i) {
+            ThreadWrapperParam param;
+            param.thread_instance = std::make_unique<ForwardStage>(i < STAGES ? stage_name(type_names[t], i + 1) : "");
+            param.thread_instance_name = stage_name(type_names[t], i);
+            param.queue_size = 1024;
+            param.mailbox_type = types[t];
+            params.push_back(std::move(param));
+        }
+        if (app.start(params) != ThreadWrapperError::OK) {
+            fprintf(stderr, "failed to start pipeline\n");
+            return 1;
+        }
+        const int first_id = params.front().thread_instance_id;
+
+        for (int p = 0; p < 3; ++p) {
+            pump(first_id, payloads[p], WARMUP_MESSAGES);
+
+            uint64_t before = g_allocations.load();
+            pump(first_id, payloads[p], MEASURED_MESSAGES);
+            uint64_t allocations = g_allocations.load() - before;
+
+            printf("%-10s %-10s %12llu %14llu %18.6f\n", type_names[t], payload_names[p],
+                   static_cast<unsigned long long>(MEASURED_MESSAGES),
+                   static_cast<unsigned long long>(allocations),
+                   static_cast<double>(allocations) / (MEASURED_MESSAGES * STAGES));
+        }
+    }
+
+    app.stop();
+    return 0;
+}
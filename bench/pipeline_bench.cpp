@@ -0,0 +1,686 @@
+// Pipeline throughput and end-to-end latency across topologies, payload sizes, queue capacities
+// and wait policies, then the latency of a single hop in each wait mode (park, spin-then-park,
+// busy-poll) from a ping-pong between two stages, then request/reply round trips through a
+// future, the main thread's mailbox and a coroutine handler, then the cold-start time of a
+// 50-stage pipeline whose stages take a while to initialize.
+// Each scenario starts its own threads through ThreadWrapperApp and stops them afterwards.
+// Prints one JSON document on stdout.
+//
+// Usage: pipeline_bench [messages_per_scenario]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ThreadWrapper/CoroutineThreadWrapper.hpp"
+#include "ThreadWrapper/ThreadMetrics.hpp"
+#include "ThreadWrapper/ThreadWrapperApp.hpp"
+
+static constexpr uint64_t DEFAULT_MESSAGES = 100000;
+static constexpr uint32_t DEFAULT_QUEUE_CAPACITY = 1024;
+static constexpr uint32_t DEFAULT_PAYLOAD_BYTES = 16;
+
+// The send time travels in the first 8 bytes; the rest pads the payload to its nominal size.
+template<size_t BYTES>
+struct Payload {
+    static_assert(BYTES >= sizeof(uint64_t), "payload must hold the timestamp");
+    uint64_t sent_ns;
+    unsigned char padding[BYTES - sizeof(uint64_t)];
+};
+
+/// @brief Completion state shared by all sinks of the running scenario.
+struct Collector {
+    std::atomic<uint64_t> received{0};
+    uint64_t target = 0;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+
+    void arrived()
+    {
+        if (received.fetch_add(1, std::memory_order_acq_rel) + 1 == target) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            done_cv.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this]() { return done; });
+    }
+};
+
+// Forwards whole envelopes to its successors, round-robin. Inline payloads are never boxed.
+class RelayStage : public ThreadWrapper {
+public:
+    explicit RelayStage(std::vector<std::string> next_names) : next_names_(std::move(next_names)) {}
+
+    ThreadWrapperError initialize() override
+    {
+        for (const auto& name : next_names_) {
+            int id = get_thread_wrapper_id_by_name(name);
+            if (id == INVALID_INSTANCE_ID) {
+                return ThreadWrapperError::INVALID_ARGS;
+            }
+            next_ids_.push_back(id);
+        }
+        return ThreadWrapperError::OK;
+    }
+
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        int next_id = next_ids_[next_index_];
+        next_index_ = next_index_ + 1 == next_ids_.size() ? 0 : next_index_ + 1;
+        return get_thread_wrapper_app_instance().send_envelope_wait(
+            next_id, std::move(msg), std::chrono::steady_clock::time_point::max());
+    }
+
+private:
+    std::vector<std::string> next_names_;
+    std::vector<int> next_ids_;
+    size_t next_index_ = 0;
+};
+
+// End of the pipeline: records send-to-arrival latency into its own histogram.
+template<size_t BYTES>
+class SinkStage : public ThreadWrapper {
+public:
+    SinkStage(Collector& collector, LatencyHistogram& latency) : collector_(collector), latency_(latency) {}
+
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        if (const auto* payload = msg.payload_as<Payload<BYTES>>()) {
+            latency_.record(ThreadMetrics::now_ns() - payload->sent_ns);
+        }
+        collector_.arrived();
+        return ThreadWrapperError::OK;
+    }
+
+private:
+    Collector& collector_;
+    LatencyHistogram& latency_;
+};
+
+enum class Topology { LINEAR, FAN_IN, FAN_OUT };
+
+struct Scenario {
+    Topology topology;
+    uint32_t width;          // Pipeline depth for LINEAR, N for FAN_IN / FAN_OUT.
+    uint32_t payload_bytes;
+    uint32_t queue_capacity;
+    WaitPolicy wait_policy = WaitPolicy::PARK;
+};
+
+struct Result {
+    double msgs_per_sec = 0.0;
+    HistogramSnapshot latency;
+};
+
+static const char* topology_name(Topology topology)
+{
+    switch (topology) {
+        case Topology::LINEAR:  return "linear";
+        case Topology::FAN_IN:  return "fan_in";
+        case Topology::FAN_OUT: return "fan_out";
+    }
+    return "unknown";
+}
+
+static const char* wait_policy_name(WaitPolicy policy)
+{
+    return policy == WaitPolicy::SPIN_THEN_PARK ? "spin_then_park" : "park";
+}
+
+static std::string scenario_name(const Scenario& scenario)
+{
+    std::string name = std::string(topology_name(scenario.topology)) + "_" + std::to_string(scenario.width) +
+                       "_p" + std::to_string(scenario.payload_bytes) + "_q" + std::to_string(scenario.queue_capacity);
+    return scenario.wait_policy == WaitPolicy::PARK ? name : name + "_spin";
+}
+
+static void add_stage(std::vector<ThreadWrapperParam>& params, std::unique_ptr<ThreadWrapper> stage,
+                      const std::string& name, const Scenario& scenario)
+{
+    ThreadWrapperParam param;
+    param.thread_instance = std::move(stage);
+    param.thread_instance_name = name;
+    param.queue_size = scenario.queue_capacity;
+    param.wait_policy = scenario.wait_policy;
+    params.push_back(std::move(param));
+}
+
+template<size_t BYTES>
+static Result run_scenario(const Scenario& scenario, const std::string& prefix, uint64_t messages)
+{
+    Collector collector;
+    collector.target = messages;
+    // One histogram per sink: each has a single writer.
+    std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+    std::vector<ThreadWrapperParam> params;
+    std::vector<std::string> entries; // Stages the driver sends to, round-robin.
+
+    auto add_sink = [&](const std::string& name) {
+        latencies.push_back(std::make_unique<LatencyHistogram>());
+        add_stage(params, std::make_unique<SinkStage<BYTES>>(collector, *latencies.back()), name, scenario);
+    };
+
+    switch (scenario.topology) {
+        case Topology::LINEAR:
+            // width stages in a row; the last one is the sink.
+            for (uint32_t i = 0; i + 1 < scenario.width; ++i) {
+                add_stage(params, std::make_unique<RelayStage>(
+                              std::vector<std::string>{prefix + "stage" + std::to_string(i + 1)}),
+                          prefix + "stage" + std::to_string(i), scenario);
+            }
+            add_sink(prefix + "stage" + std::to_string(scenario.width - 1));
+            entries.push_back(prefix + "stage0");
+            break;
+        case Topology::FAN_IN:
+            // width relays all feeding one sink.
+            for (uint32_t i = 0; i < scenario.width; ++i) {
+                add_stage(params, std::make_unique<RelayStage>(std::vector<std::string>{prefix + "sink"}),
+                          prefix + "relay" + std::to_string(i), scenario);
+                entries.push_back(prefix + "relay" + std::to_string(i));
+            }
+            add_sink(prefix + "sink");
+            break;
+        case Topology::FAN_OUT: {
+            // One dispatcher spreading over width sinks.
+            std::vector<std::string> sinks;
+            for (uint32_t i = 0; i < scenario.width; ++i) {
+                sinks.push_back(prefix + "sink" + std::to_string(i));
+                add_sink(sinks.back());
+            }
+            add_stage(params, std::make_unique<RelayStage>(sinks), prefix + "dispatch", scenario);
+            entries.push_back(prefix + "dispatch");
+            break;
+        }
+    }
+
+    auto& app = get_thread_wrapper_app_instance();
+    Result result;
+    if (app.start(params) != ThreadWrapperError::OK) {
+        fprintf(stderr, "failed to start scenario %s\n", prefix.c_str());
+        return result;
+    }
+    std::vector<int> stage_ids;
+    for (const auto& param : params) {
+        stage_ids.push_back(param.thread_instance_id);
+    }
+
+    std::vector<int> entry_ids;
+    for (const auto& name : entries) {
+        entry_ids.push_back(app.get_thread_wrapper_id_by_name(name));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    Payload<BYTES> payload{};
+    for (uint64_t i = 0; i < messages; ++i) {
+        payload.sent_ns = ThreadMetrics::now_ns();
+        app.send_wait(entry_ids[i % entry_ids.size()], 1, payload);
+    }
+    collector.wait();
+    auto end = std::chrono::steady_clock::now();
+
+    app.stop_threads(stage_ids);
+
+    result.msgs_per_sec = static_cast<double>(messages) / std::chrono::duration<double>(end - begin).count();
+    for (const auto& latency : latencies) {
+        result.latency.merge(latency->snapshot());
+    }
+    return result;
+}
+
+static Result run(const Scenario& scenario, const std::string& prefix, uint64_t messages)
+{
+    switch (scenario.payload_bytes) {
+        case 16:   return run_scenario<16>(scenario, prefix, messages);   // Inline in the envelope.
+        case 256:  return run_scenario<256>(scenario, prefix, messages);  // Shared, one allocation per message.
+        case 4096: return run_scenario<4096>(scenario, prefix, messages);
+    }
+    fprintf(stderr, "unsupported payload size %u\n", scenario.payload_bytes);
+    return Result();
+}
+
+// Hop latency: two stages bounce one message back and forth, so nothing is ever
+// queued and every hop pays the full wake-up cost of its wait mode. One hop is
+// half a round trip.
+enum class HopMode { PARK, SPIN_THEN_PARK, BUSY_POLL };
+
+static constexpr int PING_MSG = 1;
+static constexpr int PONG_MSG = 2;
+static constexpr uint64_t HOP_WARMUP_ROUND_TRIPS = 1000;
+
+static const char* hop_mode_name(HopMode mode)
+{
+    switch (mode) {
+        case HopMode::PARK:           return "park";
+        case HopMode::SPIN_THEN_PARK: return "spin_then_park";
+        case HopMode::BUSY_POLL:      return "busy_poll";
+    }
+    return "unknown";
+}
+
+class PingStage : public ThreadWrapper {
+public:
+    PingStage(std::string peer_name, uint64_t round_trips, LatencyHistogram& hop, Collector& collector)
+        : peer_name_(std::move(peer_name)), round_trips_(round_trips), hop_(hop), collector_(collector) {}
+
+    ThreadWrapperError initialize() override
+    {
+        peer_id_ = get_thread_wrapper_id_by_name(peer_name_);
+        return peer_id_ == INVALID_INSTANCE_ID ? ThreadWrapperError::INVALID_ARGS : ThreadWrapperError::OK;
+    }
+
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        const uint64_t now = ThreadMetrics::now_ns();
+        if (msg.msg_id == PONG_MSG && sent_ > HOP_WARMUP_ROUND_TRIPS) {
+            hop_.record((now - *msg.payload_as<uint64_t>()) / 2);
+        }
+        if (sent_ == HOP_WARMUP_ROUND_TRIPS + round_trips_) {
+            collector_.arrived();
+            return ThreadWrapperError::OK;
+        }
+        ++sent_;
+        return get_thread_wrapper_app_instance().send(peer_id_, PING_MSG, ThreadMetrics::now_ns());
+    }
+
+private:
+    std::string peer_name_;
+    int peer_id_ = INVALID_INSTANCE_ID;
+    const uint64_t round_trips_;
+    uint64_t sent_ = 0;
+    LatencyHistogram& hop_;
+    Collector& collector_;
+};
+
+class PongStage : public ThreadWrapper {
+public:
+    explicit PongStage(std::string peer_name) : peer_name_(std::move(peer_name)) {}
+
+    ThreadWrapperError initialize() override
+    {
+        peer_id_ = get_thread_wrapper_id_by_name(peer_name_);
+        return peer_id_ == INVALID_INSTANCE_ID ? ThreadWrapperError::INVALID_ARGS : ThreadWrapperError::OK;
+    }
+
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        msg.msg_id = PONG_MSG; // Bounce the envelope, timestamp and all.
+        return get_thread_wrapper_app_instance().send_envelope(peer_id_, std::move(msg));
+    }
+
+private:
+    std::string peer_name_;
+    int peer_id_ = INVALID_INSTANCE_ID;
+};
+
+struct HopResult {
+    bool pinned = false;
+    HistogramSnapshot latency;
+};
+
+static HopResult run_hop_latency(HopMode mode, const std::string& prefix, uint64_t round_trips)
+{
+    // Pin the two stages to their own cores, away from CPU 0, when there are enough.
+    const unsigned cpus = std::thread::hardware_concurrency();
+    HopResult result;
+    result.pinned = cpus >= 3;
+
+    Collector collector;
+    collector.target = 1;
+    LatencyHistogram hop;
+    std::vector<ThreadWrapperParam> params;
+    const Scenario stage_config{Topology::LINEAR, 2, sizeof(uint64_t), DEFAULT_QUEUE_CAPACITY};
+    add_stage(params, std::make_unique<PingStage>(prefix + "pong", round_trips, hop, collector), prefix + "ping",
+              stage_config);
+    add_stage(params, std::make_unique<PongStage>(prefix + "ping"), prefix + "pong", stage_config);
+    for (size_t i = 0; i < params.size(); ++i) {
+        params[i].wait_policy = mode == HopMode::SPIN_THEN_PARK ? WaitPolicy::SPIN_THEN_PARK : WaitPolicy::PARK;
+        params[i].busy_poll = mode == HopMode::BUSY_POLL;
+        if (result.pinned) {
+            params[i].cpu_affinity = {static_cast<int>(i + 1)};
+        }
+    }
+
+    auto& app = get_thread_wrapper_app_instance();
+    if (app.start(params) != ThreadWrapperError::OK) {
+        fprintf(stderr, "failed to start hop latency run %s\n", prefix.c_str());
+        return result;
+    }
+    app.send_message(params[0].thread_instance_id, PING_MSG, nullptr);
+    collector.wait();
+    app.stop_threads({params[0].thread_instance_id, params[1].thread_instance_id});
+
+    result.latency = hop.snapshot();
+    return result;
+}
+
+// Request/reply: one caller at a time asks an echo stage and waits for its answer, so each
+// round trip is a request hop, a reply, and the caller's wake-up.
+enum class RequestMode { FUTURE, MAIN_MAILBOX, COROUTINE };
+
+static const char* request_mode_name(RequestMode mode)
+{
+    switch (mode) {
+        case RequestMode::FUTURE:       return "future";
+        case RequestMode::MAIN_MAILBOX: return "main_mailbox";
+        case RequestMode::COROUTINE:    return "coroutine";
+    }
+    return "unknown";
+}
+
+class EchoStage : public ThreadWrapper {
+public:
+    ThreadWrapperError process_message(ThreadWrapperMessage& msg) override
+    {
+        return get_thread_wrapper_app_instance().reply(msg, PONG_MSG, *msg.payload_as<uint64_t>());
+    }
+};
+
+class RequesterStage : public CoroutineThreadWrapper {
+public:
+    RequesterStage(std::string echo_name, uint64_t round_trips, LatencyHistogram& rtt, Collector& collector)
+        : echo_name_(std::move(echo_name)), round_trips_(round_trips), rtt_(rtt), collector_(collector) {}
+
+    ThreadWrapperError initialize() override
+    {
+        echo_id_ = get_thread_wrapper_id_by_name(echo_name_);
+        return echo_id_ == INVALID_INSTANCE_ID ? ThreadWrapperError::INVALID_ARGS : ThreadWrapperError::OK;
+    }
+
+    HandlerTask handle(ThreadWrapperMessage) override
+    {
+        for (uint64_t i = 0; i < HOP_WARMUP_ROUND_TRIPS + round_trips_; ++i) {
+            const uint64_t start = ThreadMetrics::now_ns();
+            Reply reply = co_await request(echo_id_, PING_MSG, start);
+            if (!reply.ok()) {
+                break;
+            }
+            if (i >= HOP_WARMUP_ROUND_TRIPS) {
+                rtt_.record(ThreadMetrics::now_ns() - start);
+            }
+        }
+        collector_.arrived();
+        co_return ThreadWrapperError::OK;
+    }
+
+private:
+    std::string echo_name_;
+    int echo_id_ = INVALID_INSTANCE_ID;
+    const uint64_t round_trips_;
+    LatencyHistogram& rtt_;
+    Collector& collector_;
+};
+
+static HopResult run_request_reply(RequestMode mode, const std::string& prefix, uint64_t round_trips)
+{
+    const unsigned cpus = std::thread::hardware_concurrency();
+    HopResult result;
+    result.pinned = cpus >= 3;
+
+    Collector collector;
+    collector.target = 1;
+    LatencyHistogram rtt;
+    std::vector<ThreadWrapperParam> params;
+    const Scenario stage_config{Topology::LINEAR, 2, sizeof(uint64_t), DEFAULT_QUEUE_CAPACITY};
+    add_stage(params, std::make_unique<EchoStage>(), prefix + "echo", stage_config);
+    if (mode == RequestMode::COROUTINE) {
+        add_stage(params, std::make_unique<RequesterStage>(prefix + "echo", round_trips, rtt, collector),
+                  prefix + "requester", stage_config);
+    }
+    for (size_t i = 0; result.pinned && i < params.size(); ++i) {
+        params[i].cpu_affinity = {static_cast<int>(i + 1)};
+    }
+
+    auto& app = get_thread_wrapper_app_instance();
+    if (app.start(params) != ThreadWrapperError::OK) {
+        fprintf(stderr, "failed to start request/reply run %s\n", prefix.c_str());
+        return result;
+    }
+    const int echo_id = params[0].thread_instance_id;
+    const uint64_t total = HOP_WARMUP_ROUND_TRIPS + round_trips;
+    if (mode == RequestMode::COROUTINE) {
+        app.send_message(params[1].thread_instance_id, PING_MSG, nullptr);
+        collector.wait();
+    } else if (mode == RequestMode::FUTURE) {
+        for (uint64_t i = 0; i < total; ++i) {
+            const uint64_t start = ThreadMetrics::now_ns();
+            if (!app.send_request(echo_id, PING_MSG, start).get().ok()) {
+                break;
+            }
+            if (i >= HOP_WARMUP_ROUND_TRIPS) {
+                rtt.record(ThreadMetrics::now_ns() - start);
+            }
+        }
+    } else {
+        ExternalMailbox& mailbox = app.main_mailbox();
+        for (uint64_t i = 0; i < total; ++i) {
+            const uint64_t start = ThreadMetrics::now_ns();
+            ThreadWrapperMessage request;
+            request.msg_id = PING_MSG;
+            request.set_payload(start);
+            request.correlation_id = static_cast<uint32_t>(i + 1);
+            request.reply_to = mailbox.id();
+            if (app.send_envelope(echo_id, std::move(request)) != ThreadWrapperError::OK) {
+                break;
+            }
+            ThreadWrapperMessage reply;
+            mailbox.receive(reply);
+            if (i >= HOP_WARMUP_ROUND_TRIPS) {
+                rtt.record(ThreadMetrics::now_ns() - start);
+            }
+        }
+    }
+
+    std::vector<int> ids;
+    for (const auto& param : params) {
+        ids.push_back(param.thread_instance_id);
+    }
+    app.stop_threads(ids);
+
+    result.latency = rtt.snapshot();
+    return result;
+}
+
+// Cold start: a linear pipeline whose stages each spend `init_cost` in initialize(), standing in
+// for loading a model or opening a device. start() runs the initializations in parallel, so the
+// time to the first message through the whole pipeline should stay near one init_cost.
+static constexpr uint32_t COLD_START_STAGES = 50;
+
+template<typename Stage>
+class SlowInit : public Stage {
+public:
+    template<typename... Args>
+    explicit SlowInit(std::chrono::milliseconds init_cost, Args&&... args)
+        : Stage(std::forward<Args>(args)...), init_cost_(init_cost) {}
+
+    ThreadWrapperError initialize() override
+    {
+        std::this_thread::sleep_for(init_cost_);
+        return Stage::initialize();
+    }
+
+private:
+    std::chrono::milliseconds init_cost_;
+};
+
+struct ColdStartResult {
+    double start_ms = 0.0;         // start() until it returned.
+    double first_message_ms = 0.0; // start() until one message had crossed every stage.
+    double stop_ms = 0.0;
+};
+
+static ColdStartResult run_cold_start(std::chrono::milliseconds init_cost, const std::string& prefix)
+{
+    ColdStartResult result;
+    Collector collector;
+    collector.target = 1;
+    LatencyHistogram latency;
+    std::vector<ThreadWrapperParam> params;
+    const Scenario stage_config{Topology::LINEAR, COLD_START_STAGES, DEFAULT_PAYLOAD_BYTES, DEFAULT_QUEUE_CAPACITY};
+    for (uint32_t i = 0; i + 1 < COLD_START_STAGES; ++i) {
+        add_stage(params, std::make_unique<SlowInit<RelayStage>>(
+                      init_cost, std::vector<std::string>{prefix + "stage" + std::to_string(i + 1)}),
+                  prefix + "stage" + std::to_string(i), stage_config);
+    }
+    add_stage(params, std::make_unique<SlowInit<SinkStage<DEFAULT_PAYLOAD_BYTES>>>(init_cost, collector, latency),
+              prefix + "stage" + std::to_string(COLD_START_STAGES - 1), stage_config);
+
+    auto& app = get_thread_wrapper_app_instance();
+    const auto begin = std::chrono::steady_clock::now();
+    if (app.start(params) != ThreadWrapperError::OK) {
+        fprintf(stderr, "failed to start cold-start run %s\n", prefix.c_str());
+        return result;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    Payload<DEFAULT_PAYLOAD_BYTES> payload{};
+    payload.sent_ns = ThreadMetrics::now_ns();
+    app.send_wait(params[0].thread_instance_id, 1, payload);
+    collector.wait();
+    const auto ready = std::chrono::steady_clock::now();
+
+    std::vector<int> ids;
+    for (const auto& param : params) {
+        ids.push_back(param.thread_instance_id);
+    }
+    app.stop_threads(ids);
+    const auto stopped = std::chrono::steady_clock::now();
+
+    using Ms = std::chrono::duration<double, std::milli>;
+    result.start_ms = Ms(started - begin).count();
+    result.first_message_ms = Ms(ready - begin).count();
+    result.stop_ms = Ms(stopped - ready).count();
+    return result;
+}
+
+// Every run gets its own thread names, so logs and traces of different runs stay apart.
+static std::string run_prefix(char kind, size_t index)
+{
+    std::string prefix(1, kind);
+    prefix += std::to_string(index);
+    prefix += '-';
+    return prefix;
+}
+
+static std::vector<Scenario> build_scenarios()
+{
+    std::vector<Scenario> scenarios;
+    for (uint32_t depth : {1u, 2u, 4u, 8u, 16u}) {
+        scenarios.push_back({Topology::LINEAR, depth, DEFAULT_PAYLOAD_BYTES, DEFAULT_QUEUE_CAPACITY});
+    }
+    for (uint32_t width : {2u, 4u, 8u}) {
+        scenarios.push_back({Topology::FAN_IN, width, DEFAULT_PAYLOAD_BYTES, DEFAULT_QUEUE_CAPACITY});
+    }
+    for (uint32_t width : {2u, 4u, 8u}) {
+        scenarios.push_back({Topology::FAN_OUT, width, DEFAULT_PAYLOAD_BYTES, DEFAULT_QUEUE_CAPACITY});
+    }
+    for (uint32_t bytes : {256u, 4096u}) {
+        scenarios.push_back({Topology::LINEAR, 4, bytes, DEFAULT_QUEUE_CAPACITY});
+    }
+    for (uint32_t capacity : {16u, 64u, 256u, 4096u}) {
+        scenarios.push_back({Topology::LINEAR, 4, DEFAULT_PAYLOAD_BYTES, capacity});
+    }
+    for (uint32_t depth : {1u, 4u}) {
+        scenarios.push_back({Topology::LINEAR, depth, DEFAULT_PAYLOAD_BYTES, DEFAULT_QUEUE_CAPACITY,
+                             WaitPolicy::SPIN_THEN_PARK});
+    }
+    return scenarios;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t messages = DEFAULT_MESSAGES;
+    if (argc > 1) {
+        messages = std::strtoull(argv[1], nullptr, 10);
+        if (messages == 0) {
+            fprintf(stderr, "usage: %s [messages_per_scenario]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Scenario> scenarios = build_scenarios();
+    printf("{\n  \"benchmark\": \"pipeline\",\n  \"messages_per_scenario\": %llu,\n  \"scenarios\": [\n",
+           static_cast<unsigned long long>(messages));
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        const Scenario& scenario = scenarios[i];
+        std::string name = scenario_name(scenario);
+        Result result = run(scenario, run_prefix('b', i), messages);
+        printf("    {\"name\": \"%s\", \"topology\": \"%s\", \"width\": %u, \"payload_bytes\": %u, "
+               "\"queue_capacity\": %u, \"wait_policy\": \"%s\", \"msgs_per_sec\": %.0f, "
+               "\"latency_ns\": {\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}%s\n",
+               name.c_str(), topology_name(scenario.topology), scenario.width, scenario.payload_bytes,
+               scenario.queue_capacity, wait_policy_name(scenario.wait_policy), result.msgs_per_sec,
+               static_cast<unsigned long long>(result.latency.percentile(0.50)),
+               static_cast<unsigned long long>(result.latency.percentile(0.99)),
+               static_cast<unsigned long long>(result.latency.percentile(0.999)),
+               static_cast<unsigned long long>(result.latency.max),
+               i + 1 < scenarios.size() ? "," : "");
+        fflush(stdout);
+    }
+    printf("  ],\n  \"hop_latency\": [\n");
+    const HopMode modes[] = {HopMode::PARK, HopMode::SPIN_THEN_PARK, HopMode::BUSY_POLL};
+    const uint64_t round_trips = std::max<uint64_t>(messages / 10, 1);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        const bool last = i + 1 == sizeof(modes) / sizeof(modes[0]);
+        if (modes[i] == HopMode::BUSY_POLL && std::thread::hardware_concurrency() < 2) {
+            // Two stages spinning on one CPU only hand over at scheduler ticks.
+            printf("    {\"mode\": \"%s\", \"skipped\": \"needs at least 2 CPUs\"}%s\n",
+                   hop_mode_name(modes[i]), last ? "" : ",");
+            continue;
+        }
+        HopResult result = run_hop_latency(modes[i], run_prefix('h', i), round_trips);
+        printf("    {\"mode\": \"%s\", \"pinned\": %s, \"round_trips\": %llu, "
+               "\"hop_ns\": {\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}%s\n",
+               hop_mode_name(modes[i]), result.pinned ? "true" : "false",
+               static_cast<unsigned long long>(round_trips),
+               static_cast<unsigned long long>(result.latency.percentile(0.50)),
+               static_cast<unsigned long long>(result.latency.percentile(0.99)),
+               static_cast<unsigned long long>(result.latency.percentile(0.999)),
+               static_cast<unsigned long long>(result.latency.max),
+               last ? "" : ",");
+        fflush(stdout);
+    }
+    printf("  ],\n  \"request_reply\": [\n");
+    const RequestMode request_modes[] = {RequestMode::FUTURE, RequestMode::MAIN_MAILBOX, RequestMode::COROUTINE};
+    for (size_t i = 0; i < sizeof(request_modes) / sizeof(request_modes[0]); ++i) {
+        const bool last = i + 1 == sizeof(request_modes) / sizeof(request_modes[0]);
+        HopResult result = run_request_reply(request_modes[i], run_prefix('r', i), round_trips);
+        printf("    {\"mode\": \"%s\", \"pinned\": %s, \"round_trips\": %llu, "
+               "\"rtt_ns\": {\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}%s\n",
+               request_mode_name(request_modes[i]), result.pinned ? "true" : "false",
+               static_cast<unsigned long long>(round_trips),
+               static_cast<unsigned long long>(result.latency.percentile(0.50)),
+               static_cast<unsigned long long>(result.latency.percentile(0.99)),
+               static_cast<unsigned long long>(result.latency.percentile(0.999)),
+               static_cast<unsigned long long>(result.latency.max),
+               last ? "" : ",");
+        fflush(stdout);
+    }
+    printf("  ],\n  \"cold_start\": [\n");
+    const int init_costs_ms[] = {0, 20};
+    for (size_t i = 0; i < sizeof(init_costs_ms) / sizeof(init_costs_ms[0]); ++i) {
+        const bool last = i + 1 == sizeof(init_costs_ms) / sizeof(init_costs_ms[0]);
+        ColdStartResult result = run_cold_start(std::chrono::milliseconds(init_costs_ms[i]), run_prefix('c', i));
+        printf("    {\"stages\": %u, \"init_cost_ms\": %d, \"start_ms\": %.2f, \"first_message_ms\": %.2f, "
+               "\"stop_ms\": %.2f}%s\n",
+               COLD_START_STAGES, init_costs_ms[i], result.start_ms, result.first_message_ms, result.stop_ms,
+               last ? "" : ",");
+        fflush(stdout);
+    }
+    printf("  ]\n}\n");
+
+    get_thread_wrapper_app_instance().stop();
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Mailbox contention benchmark: N producers fan in to one consumer.
+// Compares the mutex-backed and lock-free mailbox backends.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "ThreadWrapper/Mailbox.hpp"
+
+static constexpr uint64_t TOTAL_MESSAGES = 2000000;
+static constexpr uint32_t QUEUE_CAPACITY = 1024;
+
+static const char* mailbox_type_name(MailboxType type)
+{
+    return type == MailboxType::MUTEX ? "mutex" : "lock_free";
+}
+
+static double run_once(MailboxType type, int producers)
+{
+    Mailbox mailbox(QUEUE_CAPACITY, type);
+    const uint64_t per_producer = TOTAL_MESSAGES / producers;
+    const uint64_t expected = per_producer * producers;
+
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                while (!mailbox.push(ThreadWrapperMessage())) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+
+    Mailbox::Item item;
+    for (uint64_t received = 0; received < expected; ++received) {
+        mailbox.wait_and_pop(item);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    return expected / seconds;
+}
+
+int main()
+{
+    const int producer_counts[] = {1, 4, 16, 64};
+    const MailboxType types[] = {MailboxType::MUTEX, MailboxType::LOCK_FREE};
+
+    printf("%-10s %-10s %15s\n", "mailbox", "producers", "msgs/sec");
+    for (int producers : producer_counts) {
+        for (MailboxType type : types) {
+            double rate = run_once(type, producers);
+            printf("%-10s %-10d %15.0f\n", mailbox_type_name(type), producers, rate);
+        }
+    }
+    return 0;
+}
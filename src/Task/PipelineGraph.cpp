@@ -0,0 +1,140 @@
+#include "PipelineGraph.hpp"
+
+#include <algorithm>
+
+PipelineGraph& PipelineGraph::add_stage(ThreadWrapperParam param) {
+    stages_.push_back(std::move(param));
+    return *this;
+}
+
+PipelineGraph& PipelineGraph::connect(const std::string& from, const std::string& to, const std::string& output) {
+    edges_.push_back(Edge{from, output, to});
+    return *this;
+}
+
+PipelineGraph& PipelineGraph::chain(const std::vector<std::string>& stages) {
+    for (size_t i = 0; i + 1 < stages.size(); ++i) {
+        connect(stages[i], stages[i + 1]);
+    }
+    return *this;
+}
+
+PipelineGraph& PipelineGraph::fan_out(const std::string& from, const std::vector<std::string>& to,
+                                      const std::string& output) {
+    for (const auto& target : to) {
+        connect(from, target, output);
+    }
+    return *this;
+}
+
+PipelineGraph& PipelineGraph::fan_in(const std::vector<std::string>& from, const std::string& to) {
+    for (const auto& source : from) {
+        connect(source, to);
+    }
+    return *this;
+}
+
+int PipelineGraph::find_stage(const std::string& name) const {
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (stages_[i].thread_instance_name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string PipelineGraph::validate() const {
+    if (stages_.empty()) {
+        return "the pipeline has no stages";
+    }
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        const std::string& name = stages_[i].thread_instance_name;
+        if (name.empty()) {
+            return "stage " + std::to_string(i) + " has no name";
+        }
+        if (find_stage(name) != static_cast<int>(i)) {
+            return "stage '" + name + "' is declared twice";
+        }
+    }
+    for (size_t i = 0; i < edges_.size(); ++i) {
+        const Edge& edge = edges_[i];
+        if (find_stage(edge.from) < 0) {
+            return "edge from unknown stage '" + edge.from + "'";
+        }
+        if (find_stage(edge.to) < 0) {
+            return "edge to unknown stage '" + edge.to + "'";
+        }
+        if (edge.output.empty()) {
+            return "edge '" + edge.from + "' -> '" + edge.to + "' has no output name";
+        }
+        if (edge.from == edge.to) {
+            return "stage '" + edge.from + "' sends to itself";
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (edges_[j].from == edge.from && edges_[j].output == edge.output && edges_[j].to == edge.to) {
+                return "edge '" + edge.from + "." + edge.output + "' -> '" + edge.to + "' is declared twice";
+            }
+        }
+    }
+    if (topological_order().size() != stages_.size()) {
+        return "the pipeline has a cycle";
+    }
+    return std::string();
+}
+
+std::vector<std::string> PipelineGraph::topological_order() const {
+    // Kahn's algorithm over stage indices; edges to unknown stages are ignored here.
+    std::vector<int> in_degree(stages_.size(), 0);
+    std::vector<std::vector<int>> successors(stages_.size());
+    for (const auto& edge : edges_) {
+        int from = find_stage(edge.from);
+        int to = find_stage(edge.to);
+        if (from < 0 || to < 0) {
+            continue;
+        }
+        successors[from].push_back(to);
+        in_degree[to]++;
+    }
+
+    std::vector<int> ready;
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (in_degree[i] == 0) {
+            ready.push_back(static_cast<int>(i));
+        }
+    }
+    std::vector<std::string> order;
+    for (size_t next = 0; next < ready.size(); ++next) {
+        int stage = ready[next];
+        order.push_back(stages_[stage].thread_instance_name);
+        for (int successor : successors[stage]) {
+            if (--in_degree[successor] == 0) {
+                ready.push_back(successor);
+            }
+        }
+    }
+    if (order.size() != stages_.size()) {
+        order.clear();
+    }
+    return order;
+}
+
+std::vector<ThreadWrapperParam> PipelineGraph::take_stages() {
+    for (const auto& edge : edges_) {
+        int from = find_stage(edge.from);
+        if (from < 0) {
+            continue;
+        }
+        auto& outputs = stages_[from].outputs;
+        auto it = std::find_if(outputs.begin(), outputs.end(),
+                               [&](const ThreadOutput& output) { return output.name == edge.output; });
+        if (it == outputs.end()) {
+            outputs.push_back(ThreadOutput{edge.output, {}});
+            it = outputs.end() - 1;
+        }
+        it->targets.push_back(edge.to);
+    }
+    edges_.clear();
+    std::vector<ThreadWrapperParam> stages = std::move(stages_);
+    stages_.clear();
+    return stages;
+}
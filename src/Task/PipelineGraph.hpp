@@ -0,0 +1,61 @@
+#ifndef PIPELINE_GRAPH_HPP
+#define PIPELINE_GRAPH_HPP
+
+#include <string>
+#include <vector>
+#include "ThreadWrapper/ThreadWrapper.hpp"
+
+/**
+ * @class PipelineGraph
+ * @brief Declares a task as stages joined by edges, checked before any thread starts.
+ *
+ * Each edge leaves a named output of its source stage; several edges on the
+ * same output fan out (emit() delivers to all of them), several edges into
+ * one stage fan in. validate() rejects unknown or duplicate stages, duplicate
+ * edges and cycles, and TaskManager::create_pipeline() turns the edges into
+ * ThreadWrapperParam::outputs, which are bound to thread IDs before any
+ * stage's initialize() runs. Stages then send with emit(output, ...) instead
+ * of looking destinations up by name.
+ */
+class PipelineGraph
+{
+public:
+    static constexpr const char* DEFAULT_OUTPUT = "out";
+
+    /// @brief Adds a stage. A stage whose thread already runs in another task is reused, as in create_task().
+    PipelineGraph& add_stage(ThreadWrapperParam param);
+
+    /// @brief Adds an edge from output `output` of stage `from` to stage `to`.
+    PipelineGraph& connect(const std::string& from, const std::string& to,
+                           const std::string& output = DEFAULT_OUTPUT);
+    /// @brief Connects the stages one after another through their default outputs.
+    PipelineGraph& chain(const std::vector<std::string>& stages);
+    /// @brief Connects one output of `from` to every stage in `to`.
+    PipelineGraph& fan_out(const std::string& from, const std::vector<std::string>& to,
+                           const std::string& output = DEFAULT_OUTPUT);
+    /// @brief Connects the default output of every stage in `from` to `to`.
+    PipelineGraph& fan_in(const std::vector<std::string>& from, const std::string& to);
+
+    /// @brief Checks the graph. @return An empty string if it is a valid DAG, otherwise what is wrong.
+    std::string validate() const;
+
+    /// @brief Names of the stages in topological order (sources first); empty if the graph has a cycle.
+    std::vector<std::string> topological_order() const;
+
+    /// @brief Stages with their outputs filled in from the edges. Leaves the graph empty.
+    std::vector<ThreadWrapperParam> take_stages();
+
+private:
+    struct Edge {
+        std::string from;
+        std::string output;
+        std::string to;
+    };
+
+    int find_stage(const std::string& name) const;
+
+    std::vector<ThreadWrapperParam> stages_;
+    std::vector<Edge> edges_;
+};
+
+#endif // PIPELINE_GRAPH_HPP
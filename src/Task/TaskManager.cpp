@@ -1,4 +1,5 @@
 #include "TaskManager.hpp"
+#include <algorithm>
 #include <iostream>
 
 TaskManager& TaskManager::get_instance() {
@@ -16,113 +17,195 @@ TaskManager::~TaskManager() {
             task_names.push_back(pair.first);
         }
     }
-    for (const auto& name : task_names) {
-        stop_task(name);
-    }
+    stop_tasks(task_names);
 }
 
-bool TaskManager::create_task(const std::string& task_name, std::vector<ThreadWrapperParam>& thread_params) {
+bool TaskManager::create_task(const std::string& task_name, std::vector<ThreadWrapperParam>& thread_params,
+                              std::chrono::steady_clock::duration init_timeout) {
     if (task_name.empty()) return false;
 
-    std::lock_guard<std::mutex> lock(mtx_);
-
-    if (running_tasks_.count(task_name)) {
-        std::cerr << "Error: Task '" << task_name << "' already exists." << std::endl;
-        return false;
-    }
-
-    auto& app = ThreadWrapperApp::get_instance();
     std::set<std::string> threads_for_this_task;
     std::vector<ThreadWrapperParam> threads_to_create;
+    std::vector<std::string> reused_threads;
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
 
-    // Step 1: Identify which threads are new and which are reused.
-    for (auto& param : thread_params) {
-        threads_for_this_task.insert(param.thread_instance_name);
-        
-        auto it = thread_pool_.find(param.thread_instance_name);
-        if (it != thread_pool_.end()) {
-            // Thread already exists, just increment its reference count.
-            it->second.reference_count++;
-            std::cout << "Reusing thread '" << param.thread_instance_name 
-                      << "', new reference count: " << it->second.reference_count << std::endl;
-        } else {
-            // Thread is new, add it to the list of threads to create.
-            threads_to_create.push_back(std::move(param));
-        }
-    }
+        // A thread of the same name that another call is starting or stopping must settle first:
+        // then it is either in the pool to be reused, or its name is free again.
+        transition_done_cv_.wait(lock, [&]() {
+            return std::none_of(thread_params.begin(), thread_params.end(), [this](const ThreadWrapperParam& param) {
+                return threads_in_transition_.count(param.thread_instance_name) != 0;
+            });
+        });
 
-    // Step 2: Create the new threads.
-    if (!threads_to_create.empty()) {
-        if (app.start(threads_to_create) != ThreadWrapperError::OK) {
-            // This is complex to roll back. For now, we fail.
-            // A production system would need to decrement ref counts for reused threads.
-            std::cerr << "Error: Failed to start new threads for task '" << task_name << "'." << std::endl;
+        if (running_tasks_.count(task_name) || starting_tasks_.count(task_name)) {
+            std::cerr << "Error: Task '" << task_name << "' already exists." << std::endl;
             return false;
         }
 
-        // Add newly created threads to the pool with a reference count of 1.
+        // A running thread keeps the outputs it was started with.
+        for (const auto& param : thread_params) {
+            if (!param.outputs.empty() && thread_pool_.count(param.thread_instance_name)) {
+                std::cerr << "Error: Thread '" << param.thread_instance_name
+                          << "' is already running; its outputs cannot be rebound by task '" << task_name << "'." << std::endl;
+                return false;
+            }
+        }
+
+        // Step 1: Identify which threads are new and which are reused.
+        for (auto& param : thread_params) {
+            threads_for_this_task.insert(param.thread_instance_name);
+
+            auto it = thread_pool_.find(param.thread_instance_name);
+            if (it != thread_pool_.end()) {
+                // Thread already exists, just increment its reference count.
+                it->second.reference_count++;
+                reused_threads.push_back(param.thread_instance_name);
+                std::cout << "Reusing thread '" << param.thread_instance_name
+                          << "', new reference count: " << it->second.reference_count << std::endl;
+            } else {
+                // Thread is new, add it to the list of threads to create.
+                threads_in_transition_.insert(param.thread_instance_name);
+                threads_to_create.push_back(std::move(param));
+            }
+        }
+        starting_tasks_.insert(task_name);
+    }
+
+    // Step 2: Create the new threads. Their initialize() may take long (loading a
+    // model, opening a device), so the lock is not held: other tasks can be
+    // created and stopped meanwhile.
+    bool started = threads_to_create.empty() ||
+                   ThreadWrapperApp::get_instance().start(threads_to_create, init_timeout) == ThreadWrapperError::OK;
+
+    // Step 3: Register the task, or undo step 1. start() has already removed
+    // the threads it created; the references taken on reused ones are dropped.
+    std::vector<int> threads_to_stop;
+    std::vector<std::string> thread_names_to_stop;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
         for (const auto& param : threads_to_create) {
-            PooledThreadInfo info;
-            info.id = param.thread_instance_id;
-            info.name = param.thread_instance_name;
-            info.reference_count = 1;
-            thread_pool_[info.name] = info;
-            std::cout << "Created new thread '" << info.name 
-                      << "' with ID " << info.id << std::endl;
+            threads_in_transition_.erase(param.thread_instance_name);
         }
+        starting_tasks_.erase(task_name);
+
+        if (started) {
+            // Add newly created threads to the pool with a reference count of 1.
+            for (const auto& param : threads_to_create) {
+                PooledThreadInfo info;
+                info.id = param.thread_instance_id;
+                info.name = param.thread_instance_name;
+                info.reference_count = 1;
+                thread_pool_[info.name] = info;
+                std::cout << "Created new thread '" << info.name
+                          << "' with ID " << info.id << std::endl;
+            }
+            running_tasks_[task_name] = threads_for_this_task;
+        } else {
+            for (const auto& thread_name : reused_threads) {
+                release_reference(thread_name, threads_to_stop, thread_names_to_stop);
+            }
+        }
+        transition_done_cv_.notify_all();
     }
 
-    // Step 3: Register the task.
-    running_tasks_[task_name] = threads_for_this_task;
+    if (!started) {
+        std::cerr << "Error: Failed to start new threads for task '" << task_name << "'." << std::endl;
+        stop_released_threads(threads_to_stop, thread_names_to_stop, StopMode::abort_now());
+        return false;
+    }
     std::cout << "Task '" << task_name << "' created successfully." << std::endl;
     return true;
 }
 
-bool TaskManager::stop_task(const std::string& task_name) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    
-    auto task_it = running_tasks_.find(task_name);
-    if (task_it == running_tasks_.end()) {
-        std::cerr << "Error: Task '" << task_name << "' not found." << std::endl;
+bool TaskManager::create_pipeline(const std::string& task_name, PipelineGraph& graph,
+                                  std::chrono::steady_clock::duration init_timeout) {
+    std::string error = graph.validate();
+    if (!error.empty()) {
+        std::cerr << "Error: Pipeline '" << task_name << "' is invalid: " << error << "." << std::endl;
         return false;
     }
+    std::vector<ThreadWrapperParam> stages = graph.take_stages();
+    return create_task(task_name, stages, init_timeout);
+}
+
+bool TaskManager::stop_task(const std::string& task_name, StopMode mode, StopReport* report) {
+    return stop_tasks({task_name}, mode, report);
+}
 
-    const auto& threads_used_by_task = task_it->second;
+bool TaskManager::stop_tasks(const std::vector<std::string>& task_names, StopMode mode, StopReport* report) {
+    bool all_found = true;
+    std::vector<std::string> stopped_tasks;
+    std::vector<std::string> thread_names_to_stop;
     std::vector<int> threads_to_stop;
 
-    // Step 1: Decrement reference counts for all threads used by this task.
-    for (const auto& thread_name : threads_used_by_task) {
-        auto pool_it = thread_pool_.find(thread_name);
-        if (pool_it != thread_pool_.end()) {
-            pool_it->second.reference_count--;
-            std::cout << "Decremented reference count for thread '" << thread_name 
-                      << "', new count: " << pool_it->second.reference_count << std::endl;
-            
-            // If reference count drops to zero, mark this thread for stopping.
-            if (pool_it->second.reference_count == 0) {
-                threads_to_stop.push_back(pool_it->second.id);
-                std::cout << "Thread '" << thread_name << "' is now unused and will be stopped." << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto& task_name : task_names) {
+            auto task_it = running_tasks_.find(task_name);
+            if (task_it == running_tasks_.end()) {
+                std::cerr << "Error: Task '" << task_name << "' not found." << std::endl;
+                all_found = false;
+                continue;
             }
-        }
-    }
 
-    // Step 2: Actually stop the threads whose ref count is zero.
-    if (!threads_to_stop.empty()) {
-        auto& app = ThreadWrapperApp::get_instance();
-        app.stop_threads(threads_to_stop);
-        
-        // Remove the stopped threads from the pool.
-        for (const auto& thread_name : threads_used_by_task) {
-            if (thread_pool_.count(thread_name) && thread_pool_[thread_name].reference_count == 0) {
-                thread_pool_.erase(thread_name);
+            // Step 1: Decrement reference counts for all threads used by this task.
+            for (const auto& thread_name : task_it->second) {
+                release_reference(thread_name, threads_to_stop, thread_names_to_stop);
             }
+
+            // Step 2: Remove the task itself.
+            running_tasks_.erase(task_it);
+            stopped_tasks.push_back(task_name);
         }
     }
 
-    // Step 3: Remove the task itself.
-    running_tasks_.erase(task_it);
-    std::cout << "Task '" << task_name << "' stopped successfully." << std::endl;
-    return true;
+    // Step 3: Actually stop the threads whose ref count is zero, all at once.
+    StopReport stop_report = stop_released_threads(threads_to_stop, thread_names_to_stop, mode);
+    if (report) {
+        *report = stop_report;
+    }
+
+    for (const auto& task_name : stopped_tasks) {
+        std::cout << "Task '" << task_name << "' stopped successfully." << std::endl;
+    }
+    return all_found;
+}
+
+void TaskManager::release_reference(const std::string& thread_name, std::vector<int>& threads_to_stop,
+                                    std::vector<std::string>& thread_names_to_stop) {
+    auto pool_it = thread_pool_.find(thread_name);
+    if (pool_it == thread_pool_.end()) {
+        return;
+    }
+    pool_it->second.reference_count--;
+    std::cout << "Decremented reference count for thread '" << thread_name
+              << "', new count: " << pool_it->second.reference_count << std::endl;
+
+    // If reference count drops to zero, mark this thread for stopping.
+    if (pool_it->second.reference_count == 0) {
+        threads_to_stop.push_back(pool_it->second.id);
+        thread_names_to_stop.push_back(thread_name);
+        threads_in_transition_.insert(thread_name);
+        thread_pool_.erase(pool_it);
+        std::cout << "Thread '" << thread_name << "' is now unused and will be stopped." << std::endl;
+    }
+}
+
+StopReport TaskManager::stop_released_threads(const std::vector<int>& threads_to_stop,
+                                              const std::vector<std::string>& thread_names_to_stop, StopMode mode) {
+    if (threads_to_stop.empty()) {
+        return StopReport();
+    }
+    // Without the lock, so other tasks can be created or stopped meanwhile.
+    StopReport report = ThreadWrapperApp::get_instance().stop_threads(threads_to_stop, mode);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto& thread_name : thread_names_to_stop) {
+        threads_in_transition_.erase(thread_name);
+    }
+    transition_done_cv_.notify_all();
+    return report;
 }
 
 
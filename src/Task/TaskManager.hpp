@@ -7,7 +7,10 @@
 #include <set>
 #include <memory>
 #include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include "ThreadWrapper/ThreadWrapperApp.hpp"
+#include "Task/PipelineGraph.hpp"
 
 // Represents a thread in the global pool, with its reference count.
 struct PooledThreadInfo {
@@ -30,17 +33,45 @@ public:
      * @param thread_params A list of parameters for threads this task needs.
      *        If a thread with the same name already exists, it will be reused.
      *        If not, it will be created.
+     * @param init_timeout Limit for initializing all new threads together (zero: none).
+     *        The task manager's lock is not held meanwhile. On failure or
+     *        timeout only the new threads are removed, and the references
+     *        taken on reused threads are dropped again.
      * @return true on success.
      */
-    bool create_task(const std::string& task_name, std::vector<ThreadWrapperParam>& thread_params);
+    bool create_task(const std::string& task_name, std::vector<ThreadWrapperParam>& thread_params,
+                     std::chrono::steady_clock::duration init_timeout = std::chrono::steady_clock::duration::zero());
+
+    /**
+     * @brief Validates `graph` and creates a task from its stages, with each
+     * stage's outputs bound to the thread IDs of its successors before any
+     * stage initializes. The graph is consumed; `init_timeout` is as for create_task().
+     * @return false if the graph is invalid, if a reused stage would need new
+     *         outputs, or if create_task() fails.
+     */
+    bool create_pipeline(const std::string& task_name, PipelineGraph& graph,
+                         std::chrono::steady_clock::duration init_timeout = std::chrono::steady_clock::duration::zero());
 
     /**
      * @brief Stops a task. This decrements the reference count of associated threads.
      * A thread is only truly stopped if its reference count drops to zero.
+     * The threads are joined without holding the task manager's lock, so
+     * several tasks can be stopped concurrently.
      * @param task_name The name of the task to stop.
+     * @param mode Whether the stopped threads drain or discard their backlog; see ThreadWrapperApp::stop_threads().
+     * @param report If not null, receives what the stopped threads did with their backlog.
      * @return true on success, false if the task is not found.
      */
-    bool stop_task(const std::string& task_name);
+    bool stop_task(const std::string& task_name, StopMode mode = StopMode::abort_now(),
+                   StopReport* report = nullptr);
+
+    /**
+     * @brief Stops several tasks at once: all of their unused threads are
+     * signalled together and wind down in parallel.
+     * @return false if any task is not found; the others are stopped anyway.
+     */
+    bool stop_tasks(const std::vector<std::string>& task_names, StopMode mode = StopMode::abort_now(),
+                    StopReport* report = nullptr);
 
     std::vector<TaskDetails> get_all_task_details() const;
 
@@ -51,13 +82,26 @@ private:
     TaskManager();
     ~TaskManager();
 
+    // Drops one reference; a thread left unused leaves the pool and is queued for stopping. Caller holds mtx_.
+    void release_reference(const std::string& thread_name, std::vector<int>& threads_to_stop,
+                           std::vector<std::string>& thread_names_to_stop);
+    // Stops threads that left the pool, without holding mtx_, then frees their names.
+    StopReport stop_released_threads(const std::vector<int>& threads_to_stop,
+                                     const std::vector<std::string>& thread_names_to_stop, StopMode mode);
+
     // The global pool of all active threads, mapped by their unique name.
     std::map<std::string, PooledThreadInfo> thread_pool_;
 
     // Maps a task name to the set of thread names it uses.
     std::map<std::string, std::set<std::string>> running_tasks_;
 
-    mutable std::mutex mtx_; // A single mutex to protect both maps for simplicity.
+    // Thread names being started or stopped outside the lock, and tasks still
+    // starting; a call that needs one of these threads waits for it to settle.
+    std::set<std::string> threads_in_transition_;
+    std::set<std::string> starting_tasks_;
+    std::condition_variable transition_done_cv_;
+
+    mutable std::mutex mtx_; // A single mutex to protect the maps and set for simplicity.
 };
 
 inline TaskManager& get_task_manager_instance() {
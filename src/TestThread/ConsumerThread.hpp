@@ -19,14 +19,14 @@ public:
         return ThreadWrapperError::OK;
     }
 
-    ThreadWrapperError process(int msg_id, std::shared_ptr<void> data) override {
-        if (static_cast<MessageId>(msg_id) == MessageId::PROCESS_PIPELINE_MSG) {
-            auto msg = std::static_pointer_cast<PipelineMessage>(data);
+    ThreadWrapperError process_message(ThreadWrapperMessage& message) override {
+        if (static_cast<MessageId>(message.msg_id) == MessageId::PROCESS_PIPELINE_MSG) {
+            auto msg = message.shared_payload_as<PipelineMessage>();
+            if (!msg) {
+                return ThreadWrapperError::OK;
+            }
             msg->value += 2;
             
-            if (!msg->routing_slip.empty()) {
-                
-            }
             if (!result_queue_->push(msg)) {
                 // LOG_WARN("Consumer '{}': Result queue is full. Message was dropped.", self_instance_name());
             }
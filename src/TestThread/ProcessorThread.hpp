@@ -4,47 +4,62 @@
 #include "ThreadWrapper/ThreadWrapper.hpp"
 #include "ThreadWrapper/ThreadWrapperApp.hpp"
 #include "param.hpp"
+#include <chrono>
+#include <thread>
 
-inline ThreadWrapperError send_with_retry(int dest_id, MessageId msg_id, std::shared_ptr<void> data);
+inline ThreadWrapperError send_blocking(int dest_id, MessageId msg_id, std::shared_ptr<PipelineMessage> msg);
 
 class ProcessorThread : public ThreadWrapper {
 public:
-    ProcessorThread() = default;
+    // work_time 模拟每条消息的处理耗时，用于演示积压；init_time 模拟缓慢的初始化，用于演示启动超时
+    explicit ProcessorThread(std::chrono::milliseconds work_time = std::chrono::milliseconds(0),
+                             std::chrono::milliseconds init_time = std::chrono::milliseconds(0))
+        : work_time_(work_time), init_time_(init_time) {}
 
     ThreadWrapperError initialize() override {
+        if (init_time_.count() > 0) {
+            std::this_thread::sleep_for(init_time_);
+        }
         return ThreadWrapperError::OK;
     }
 
-    ThreadWrapperError process(int msg_id, std::shared_ptr<void> data) override
+    ThreadWrapperError process_message(ThreadWrapperMessage& message) override
     {
-        if (static_cast<MessageId>(msg_id) == MessageId::PROCESS_PIPELINE_MSG) 
+        if (static_cast<MessageId>(message.msg_id) == MessageId::PROCESS_PIPELINE_MSG) 
         {
-            auto msg = std::static_pointer_cast<PipelineMessage>(data);
+            auto msg = message.shared_payload_as<PipelineMessage>();
+            if (!msg) {
+                return ThreadWrapperError::OK;
+            }
 
+            if (work_time_.count() > 0) {
+                std::this_thread::sleep_for(work_time_);
+            }
             msg->value += 1;
             
             forward_message(msg);
         }
-        return ThreadWrapperError::OK;;
+        return ThreadWrapperError::OK;
     }
 
 private:
+    std::chrono::milliseconds work_time_;
+    std::chrono::milliseconds init_time_;
+
     void forward_message(const std::shared_ptr<PipelineMessage>& msg) 
     {
-        if (msg->routing_slip.empty()) {
-            // LOG_ERROR("Processor '{}' received a message with an empty route. This should be handled by the consumer.", self_instance_name());
+        // 由 PipelineGraph 创建时，下一站已在启动前绑定到输出上，扇出时所有下游共享同一条消息
+        if (output_count() > 0) {
+            emit(static_cast<int>(MessageId::PROCESS_PIPELINE_MSG), msg);
             return;
         }
-
-        std::string next_thread_name = msg->routing_slip.back();
-        msg->routing_slip.pop_back();
-        int next_thread_id = get_thread_wrapper_id_by_name(next_thread_name);
-
+        int next_thread_id = msg->advance_route();
         if (next_thread_id == INVALID_INSTANCE_ID) {
+            // LOG_ERROR("Processor '{}' received a message with an empty route. This should be handled by the consumer.", self_instance_name());
             return;
         }
         
-        send_with_retry(next_thread_id, MessageId::PROCESS_PIPELINE_MSG, msg);
+        send_blocking(next_thread_id, MessageId::PROCESS_PIPELINE_MSG, msg);
     }
 };
 
@@ -1,6 +1,7 @@
 #ifndef PRODUCER_THREAD_HPP
 #define PRODUCER_THREAD_HPP
 
+#include <chrono>
 #include <random>
 #include <stdexcept>
 #include <iostream>
@@ -20,30 +21,29 @@ inline int generate_value(int min_val, int max_val) {
 }
 
 
-inline ThreadWrapperError send_with_retry(int dest_id, MessageId msg_id, std::shared_ptr<void> data) {
-    ThreadWrapperError ret;
-    while (true) {
-        ret = send_message(dest_id, static_cast<int>(msg_id), data);
-        if (ret == ThreadWrapperError::ENQUEUE_FAILED) {
-            // 队列已满，稍作等待后重试，避免CPU空转
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            continue;
-        }
-        // 发送成功或遇到不可恢复的错误时退出循环
-        break;
-    }
-    return ret;
+// 队列满时阻塞等待，目标线程一腾出空位即被唤醒（不再轮询重试）
+// 以带类型的共享负载发送，接收方可在调试构建中校验类型
+inline ThreadWrapperError send_blocking(int dest_id, MessageId msg_id, std::shared_ptr<PipelineMessage> msg) {
+    return get_thread_wrapper_app_instance().send_wait(dest_id, static_cast<int>(msg_id), std::move(msg));
 }
 
 
 // 管道的发起者，负责创建消息并启动管道流程
 class ProducerThread : public ThreadWrapper {
 public:
-    // 构造时传入完整的路由路径（反向）
-    explicit ProducerThread(std::vector<std::string> pipeline_route) 
-        : pipeline_route_(std::move(pipeline_route)) {}
+    // 构造时传入完整的路由路径（反向，与 pop_back 取下一站的旧约定保持一致）
+    // interval 为收到 APP_START 后产生消息的周期
+    explicit ProducerThread(std::vector<std::string> pipeline_route,
+                            std::chrono::steady_clock::duration interval = std::chrono::milliseconds(1))
+        : pipeline_route_(std::move(pipeline_route)), interval_(interval) {}
 
+    // 初始化时把线程名编译成 ID 列表，之后每条消息只携带指向它的指针
     ThreadWrapperError initialize() override {
+        std::vector<std::string> forward_route(pipeline_route_.rbegin(), pipeline_route_.rend());
+        compiled_route_ = compile_route(forward_route);
+        if (!compiled_route_) {
+            return ThreadWrapperError::INVALID_ARGS;
+        }
         // LOG_INFO("Producer '{}' initialized.", self_instance_name());
         return ThreadWrapperError::OK;
     }
@@ -53,6 +53,14 @@ public:
 
         switch (message_id_enum) {
             case MessageId::APP_START:
+                create_and_send_message();
+                // 由定时器轮周期性地触发下一条消息，不再给自己循环发消息空转；
+                // 线程停止时在 on_stop() 中取消
+                if (!timer_.valid()) {
+                    timer_ = schedule_periodic(self_instance_id(), static_cast<int>(MessageId::CREATE_PIPELINE_MSG),
+                                               nullptr, interval_);
+                }
+                break;
             case MessageId::CREATE_PIPELINE_MSG:
                 create_and_send_message();
                 break;
@@ -63,39 +71,42 @@ public:
         return ThreadWrapperError::OK;
     }
 
+    // 停止时取消周期定时器，不留给定时器轮在投递失败后才回收
+    void on_stop() override {
+        if (timer_.valid()) {
+            cancel_timer(timer_);
+            timer_ = TimerHandle{};
+        }
+    }
+
 private:
     void create_and_send_message() {
         auto msg = std::make_shared<PipelineMessage>();
-        msg->routing_slip = pipeline_route_; // 设置路由单
+        msg->route = compiled_route_; // 共享已编译的路由，无需复制
         msg->value = generate_value(1, 100);
         
         forward_message(msg);
-
-        // 为了持续演示，再给自己发送一个消息以创建下一个管道消息
-        ThreadWrapperError ret = send_message(self_instance_id(), static_cast<int>(MessageId::CREATE_PIPELINE_MSG), nullptr);
-        if (ret != ThreadWrapperError::OK) {
-            // LOG_ERROR("Producer '{}' failed to schedule next message creation. Error: {}", self_instance_name(), static_cast<int>(ret));
-        }
     }
 
     void forward_message(const std::shared_ptr<PipelineMessage>& msg) {
-        if (msg->routing_slip.empty()) {
-            // LOG_WARN("Producer '{}' received a message with an empty route.", self_instance_name());
+        // 由 PipelineGraph 创建时，下一站已在启动前绑定到输出上
+        if (output_count() > 0) {
+            emit(static_cast<int>(MessageId::PROCESS_PIPELINE_MSG), msg);
             return;
         }
-
-        std::string next_thread_name = msg->routing_slip.back();
-        msg->routing_slip.pop_back();
-        int next_thread_id = get_thread_wrapper_id_by_name(next_thread_name);
-
+        int next_thread_id = msg->advance_route();
         if (next_thread_id == INVALID_INSTANCE_ID) {
+            // LOG_WARN("Producer '{}' received a message with an empty route.", self_instance_name());
             return;
         }
 
-        send_with_retry(next_thread_id, MessageId::PROCESS_PIPELINE_MSG, msg);
+        send_blocking(next_thread_id, MessageId::PROCESS_PIPELINE_MSG, msg);
     }
 
     std::vector<std::string> pipeline_route_;
+    const CompiledRoute* compiled_route_ = nullptr;
+    std::chrono::steady_clock::duration interval_;
+    TimerHandle timer_;
 };
 
 #endif // PRODUCER_THREAD_HPP
\ No newline at end of file
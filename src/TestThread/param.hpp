@@ -5,6 +5,7 @@
 #include <string>
 #include <cstdint>
 #include <memory>
+#include "ThreadWrapper/CompiledRoute.hpp"
 
 // 使用 enum class 增强类型安全和代码清晰度
 enum class MessageId {
@@ -15,10 +16,18 @@ enum class MessageId {
 
 // 消息体，包含路由信息和数据
 // 命名更具体，反映其在管道中的作用
+// 路由在创建任务时编译一次，所有消息共享同一个 CompiledRoute，每一跳只需按下标取下一站 ID
 struct PipelineMessage
 {
-    std::vector<std::string> routing_slip;
+    const CompiledRoute* route = nullptr;
+    uint32_t next_hop = 0;
     uint32_t value;
+
+    // 返回下一站的线程 ID 并前进一跳；路由走完时返回 INVALID_INSTANCE_ID
+    int advance_route()
+    {
+        return route ? route->hop(next_hop++) : INVALID_INSTANCE_ID;
+    }
 };
 
 #endif // PARAM_HPP
\ No newline at end of file
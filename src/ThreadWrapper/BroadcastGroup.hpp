@@ -0,0 +1,76 @@
+#ifndef BROADCAST_GROUP_HPP
+#define BROADCAST_GROUP_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include "ThreadWrapper/ThreadWrapper.hpp"
+
+/**
+ * @struct MulticastResult
+ * @brief Outcome of one multicast: how many destinations got the message and which did not.
+ */
+struct MulticastResult {
+    uint32_t delivered = 0;
+    /// (dest_id, error) for every destination that was not reached, in send order.
+    /// Left empty, so nothing is allocated, when all destinations were reached.
+    std::vector<std::pair<int, ThreadWrapperError>> failures;
+
+    bool all_delivered() const noexcept { return failures.empty(); }
+};
+
+/**
+ * @class BroadcastGroup
+ * @brief A named set of destination threads, with each member's thread ID resolved ahead of time.
+ *
+ * Created with ThreadWrapperApp::create_broadcast_group() and owned by the
+ * application, so the pointer stays valid for the application's lifetime.
+ * When a member is re-created under its old name the application rebinds it
+ * to the new ID; until then, broadcasts report that member as a failure.
+ */
+class BroadcastGroup
+{
+public:
+    BroadcastGroup(std::string name, std::vector<std::string> member_names, const std::vector<int>& members)
+        : name_(std::move(name)), member_names_(std::move(member_names)),
+          members_(std::make_unique<std::atomic<int>[]>(member_names_.size()))
+    {
+        for (size_t i = 0; i < member_names_.size(); ++i) 
+        {
+            members_[i].store(members[i], std::memory_order_relaxed);
+        }
+    }
+
+    BroadcastGroup(const BroadcastGroup&) = delete;
+    BroadcastGroup& operator=(const BroadcastGroup&) = delete;
+
+    const std::string& name() const noexcept { return name_; }
+    const std::vector<std::string>& member_names() const noexcept { return member_names_; }
+
+    /// @brief Number of members.
+    size_t size() const noexcept { return member_names_.size(); }
+    /// @brief Current thread ID of member `index`.
+    int member(size_t index) const noexcept { return members_[index].load(std::memory_order_relaxed); }
+
+    /// @brief Points every member named `name` at `id`. Called by the application under its lock.
+    void rebind(const std::string& name, int id) noexcept
+    {
+        for (size_t i = 0; i < member_names_.size(); ++i) 
+        {
+            if (member_names_[i] == name) 
+            {
+                members_[i].store(id, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    const std::string name_;
+    const std::vector<std::string> member_names_;
+    const std::unique_ptr<std::atomic<int>[]> members_;
+};
+
+#endif // BROADCAST_GROUP_HPP
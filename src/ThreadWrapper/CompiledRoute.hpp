@@ -0,0 +1,67 @@
+#ifndef COMPILED_ROUTE_HPP
+#define COMPILED_ROUTE_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "ThreadWrapper/ThreadWrapper.hpp"
+
+/**
+ * @class CompiledRoute
+ * @brief A fixed list of hops by thread name, with each hop's thread ID resolved ahead of time.
+ *
+ * Obtain one from ThreadWrapperApp::compile_route(). Routes are owned by the
+ * application and outlive every message, so messages carry a plain pointer
+ * plus a hop index instead of a copy of the route, and each hop is one array
+ * read no matter how long the route is or how many threads exist.
+ *
+ * A route is shared by everyone who compiles the same names. When a thread on
+ * it is re-created under its old name, the application rebinds that hop to the
+ * new ID, so restarting a stage neither strands the route nor allocates a new one.
+ */
+class CompiledRoute
+{
+public:
+    CompiledRoute(std::vector<std::string> names, const std::vector<int>& hops)
+        : names_(std::move(names)), hops_(std::make_unique<std::atomic<int>[]>(names_.size()))
+    {
+        for (size_t i = 0; i < names_.size(); ++i) 
+        {
+            hops_[i].store(hops[i], std::memory_order_relaxed);
+        }
+    }
+
+    CompiledRoute(const CompiledRoute&) = delete;
+    CompiledRoute& operator=(const CompiledRoute&) = delete;
+
+    /// @brief Number of hops on the route.
+    size_t length() const noexcept { return names_.size(); }
+
+    /// @brief Destination of hop `index`, or INVALID_INSTANCE_ID past the end of the route.
+    int hop(size_t index) const noexcept
+    {
+        return index < names_.size() ? hops_[index].load(std::memory_order_relaxed) : INVALID_INSTANCE_ID;
+    }
+
+    const std::vector<std::string>& names() const noexcept { return names_; }
+
+    /// @brief Points every hop named `name` at `id`. Called by the application under its lock.
+    void rebind(const std::string& name, int id) noexcept
+    {
+        for (size_t i = 0; i < names_.size(); ++i) 
+        {
+            if (names_[i] == name) 
+            {
+                hops_[i].store(id, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    const std::vector<std::string> names_;
+    const std::unique_ptr<std::atomic<int>[]> hops_;
+};
+
+#endif // COMPILED_ROUTE_HPP
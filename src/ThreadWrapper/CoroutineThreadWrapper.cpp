@@ -0,0 +1,185 @@
+#include "ThreadWrapper/CoroutineThreadWrapper.hpp"
+
+#include "ThreadWrapper/TimerWheel.hpp"
+
+namespace {
+ThreadWrapperMessage make_wake(uint32_t correlation_id, int msg_id, MessagePriority priority)
+{
+    ThreadWrapperMessage wake;
+    wake.msg_id = msg_id;
+    wake.kind = MessageKind::REPLY;
+    wake.correlation_id = correlation_id;
+    wake.priority = priority;
+    return wake;
+}
+
+// Runs on whichever thread freed the space, so it only posts to the owner's mailbox.
+void send_wake(int owner_id, uint32_t correlation_id)
+{
+    ThreadWrapperApp& app = ThreadWrapperApp::get_instance();
+    ThreadWrapperMessage wake = make_wake(correlation_id, CoroutineThreadWrapper::WAKE_MSG_ID, MessagePriority::HIGH);
+    if (app.send_envelope(owner_id, wake) == ThreadWrapperError::ENQUEUE_FAILED) {
+        // The owner's own high lane is full; let the timer wheel retry until it fits.
+        app.send_envelope_after(owner_id, std::move(wake), TimerWheel::TICK);
+    }
+}
+}
+
+CoroutineThreadWrapper::~CoroutineThreadWrapper()
+{
+    // Timers and space callbacks still pending for these frames find no
+    // waiter any more and are dropped.
+    for (auto& entry : waits_) {
+        entry.second.coroutine.destroy();
+    }
+}
+
+ThreadWrapperError CoroutineThreadWrapper::process_message(ThreadWrapperMessage& message)
+{
+    if (message.kind == MessageKind::REPLY) {
+        return on_reply(message);
+    }
+    return run(handle(std::move(message)).release());
+}
+
+ThreadWrapperError CoroutineThreadWrapper::run(HandlerTask::Handle coroutine)
+{
+    coroutine.resume();
+    if (!coroutine.done()) {
+        return ThreadWrapperError::OK; // Suspended; waits_ owns the frame now.
+    }
+    ThreadWrapperError result = coroutine.promise().result;
+    coroutine.destroy();
+    return result;
+}
+
+ThreadWrapperError CoroutineThreadWrapper::resume(WaitMap::iterator it)
+{
+    // The handler may suspend again and insert into waits_, so nothing may
+    // refer into the map once it runs.
+    HandlerTask::Handle coroutine = it->second.coroutine;
+    waits_.erase(it);
+    return run(coroutine);
+}
+
+ThreadWrapperError CoroutineThreadWrapper::on_reply(ThreadWrapperMessage& message)
+{
+    auto it = waits_.find(message.correlation_id);
+    if (it == waits_.end()) {
+        return ThreadWrapperError::OK; // Late reply after a timeout, or a stale wake-up.
+    }
+    Wait& wait = it->second;
+    ThreadWrapperApp& app = ThreadWrapperApp::get_instance();
+
+    if (message.msg_id == TIMEOUT_MSG_ID) {
+        if (wait.reply) {
+            wait.reply->error = ThreadWrapperError::TIMEOUT;
+        }
+        return resume(it);
+    }
+
+    if (message.msg_id == WAKE_MSG_ID) {
+        if (!wait.pending_send) {
+            return resume(it); // sleep_for()
+        }
+        ThreadWrapperError ret = app.send_envelope(wait.dest_id, ThreadWrapperMessage(*wait.pending_send));
+        if (ret == ThreadWrapperError::ENQUEUE_FAILED) {
+            wait_for_space(message.correlation_id, wait.dest_id, wait.pending_send->priority);
+            return ThreadWrapperError::OK;
+        }
+        wait.pending_send = nullptr;
+        if (wait.result) {
+            *wait.result = ret;
+            return resume(it);
+        }
+        if (ret != ThreadWrapperError::OK) {
+            app.cancel_timer(wait.timeout);
+            wait.reply->error = ret;
+            return resume(it);
+        }
+        return ThreadWrapperError::OK; // The request is out; keep waiting for its reply.
+    }
+
+    if (!wait.reply || wait.pending_send) {
+        return ThreadWrapperError::OK; // Not waiting for a reply under this ID.
+    }
+    if (wait.timeout.valid()) {
+        app.cancel_timer(wait.timeout);
+    }
+    if (message.msg_id == REQUEST_DROPPED_MSG_ID) {
+        wait.reply->error = ThreadWrapperError::THREAD_ABNORMAL; // The destination stopped first.
+        return resume(it);
+    }
+    wait.reply->message = std::move(message);
+    return resume(it);
+}
+
+bool CoroutineThreadWrapper::begin_send(HandlerTask::Handle coroutine, int dest_id, ThreadWrapperMessage& message,
+                                        Reply* reply, ThreadWrapperError* result, Duration timeout)
+{
+    ThreadWrapperApp& app = ThreadWrapperApp::get_instance();
+    const uint32_t id = next_correlation_id();
+    if (reply) {
+        message.correlation_id = id;
+        message.reply_to = self_instance_id();
+    }
+
+    // send_envelope() consumes its argument even when the queue is full, so
+    // send a copy (a reference count on the payload) and keep the original.
+    ThreadWrapperError ret = app.send_envelope(dest_id, ThreadWrapperMessage(message));
+    bool wait_for_room = ret == ThreadWrapperError::ENQUEUE_FAILED;
+    if (!wait_for_room && (ret != ThreadWrapperError::OK || !reply)) {
+        if (reply) {
+            reply->error = ret;
+        } else {
+            *result = ret;
+        }
+        return false; // Done without suspending.
+    }
+
+    Wait& wait = waits_[id];
+    wait.coroutine = coroutine;
+    wait.reply = reply;
+    wait.result = result;
+    wait.dest_id = dest_id;
+    if (reply && timeout > Duration::zero()) {
+        wait.timeout = app.send_envelope_after(self_instance_id(),
+                                               make_wake(id, TIMEOUT_MSG_ID, MessagePriority::NORMAL), timeout);
+    }
+    if (wait_for_room) {
+        wait.pending_send = &message;
+        wait_for_space(id, dest_id, message.priority);
+    }
+    return true;
+}
+
+bool CoroutineThreadWrapper::begin_sleep(HandlerTask::Handle coroutine, Duration delay)
+{
+    const uint32_t id = next_correlation_id();
+    TimerHandle timer = ThreadWrapperApp::get_instance().send_envelope_after(
+        self_instance_id(), make_wake(id, WAKE_MSG_ID, MessagePriority::NORMAL), delay);
+    if (!timer.valid()) {
+        return false;
+    }
+    waits_[id].coroutine = coroutine;
+    return true;
+}
+
+void CoroutineThreadWrapper::wait_for_space(uint32_t id, int dest_id, MessagePriority priority)
+{
+    const int owner_id = self_instance_id();
+    if (!ThreadWrapperApp::get_instance().notify_when_space(dest_id, priority,
+                                                            [owner_id, id]() { send_wake(owner_id, id); })) {
+        // Room already, or the destination is gone: retry (and report) from
+        // the mailbox rather than recursing here.
+        send_wake(owner_id, id);
+    }
+}
+
+uint32_t CoroutineThreadWrapper::next_correlation_id()
+{
+    do {
+        ++last_correlation_id_;
+    } while (last_correlation_id_ == 0 || waits_.count(last_correlation_id_) != 0);
+    return last_correlation_id_;
+}
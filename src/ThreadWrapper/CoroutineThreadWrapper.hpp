@@ -0,0 +1,215 @@
+#ifndef COROUTINE_THREAD_WRAPPER_HPP
+#define COROUTINE_THREAD_WRAPPER_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include "ThreadWrapper/RequestReply.hpp"
+#include "ThreadWrapper/ThreadWrapper.hpp"
+#include "ThreadWrapper/ThreadWrapperApp.hpp"
+
+/**
+ * @class HandlerTask
+ * @brief Return type of CoroutineThreadWrapper::handle(). The coroutine ends
+ * with `co_return ThreadWrapperError::OK;` (non-zero terminates the thread,
+ * as for process()).
+ */
+class HandlerTask
+{
+public:
+    struct promise_type {
+        ThreadWrapperError result = ThreadWrapperError::OK;
+
+        HandlerTask get_return_object() noexcept
+        {
+            return HandlerTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(ThreadWrapperError error) noexcept { result = error; }
+        void unhandled_exception() noexcept { result = ThreadWrapperError::ERROR; }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    HandlerTask(HandlerTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    HandlerTask(const HandlerTask&) = delete;
+    HandlerTask& operator=(const HandlerTask&) = delete;
+    HandlerTask& operator=(HandlerTask&&) = delete;
+    ~HandlerTask()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    /// @brief Hands the coroutine over to the caller, who then owns the frame.
+    Handle release() noexcept { return std::exchange(handle_, {}); }
+
+private:
+    explicit HandlerTask(Handle handle) noexcept : handle_(handle) {}
+
+    Handle handle_;
+};
+
+/**
+ * @class CoroutineThreadWrapper
+ * @brief A ThreadWrapper whose handler is a C++20 coroutine.
+ *
+ * handle() is started for every message and may `co_await` a reply to a
+ * request, a timer, or room in a full destination queue. A suspended handler
+ * costs its coroutine frame and nothing else: the worker goes on with the
+ * next message, and the handler is resumed on the same thread when the
+ * awaited event arrives as a REPLY message in this thread's mailbox, so
+ * thousands of requests can be in flight on one thread and handlers never
+ * need locks. Timers and capacity waits are driven by the application's
+ * timer wheel and by the destination's consumer, not by a blocked thread.
+ *
+ * Correlation IDs are per thread; message IDs below zero are reserved for
+ * the wake-ups and must not be used for replies.
+ *
+ * Example:
+ *   HandlerTask handle(ThreadWrapperMessage message) override {
+ *       Reply a = co_await request(shard_a_, MSG_LOOKUP, key);
+ *       Reply b = co_await request(shard_b_, MSG_LOOKUP, key, std::chrono::milliseconds(50));
+ *       co_await send_when_ready(sink_, MSG_RESULT, merge(a, b));
+ *       co_return ThreadWrapperError::OK;
+ *   }
+ */
+class CoroutineThreadWrapper : public ThreadWrapper
+{
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    static constexpr int WAKE_MSG_ID = -1;    // Timer fired or destination has room.
+    static constexpr int TIMEOUT_MSG_ID = -2; // Request timed out.
+
+    CoroutineThreadWrapper() = default;
+    ~CoroutineThreadWrapper() override;
+
+    /// @brief Handles one message. Runs until its first suspension before the next message is taken.
+    virtual HandlerTask handle(ThreadWrapperMessage message) = 0;
+
+    ThreadWrapperError process_message(ThreadWrapperMessage& message) final;
+
+    /// @brief Number of handlers currently suspended.
+    size_t suspended_count() const noexcept { return waits_.size(); }
+
+protected:
+    class RequestAwaiter
+    {
+    public:
+        RequestAwaiter(CoroutineThreadWrapper& owner, int dest_id, ThreadWrapperMessage message, Duration timeout)
+            : owner_(owner), dest_id_(dest_id), message_(std::move(message)), timeout_(timeout) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(HandlerTask::Handle coroutine)
+        {
+            return owner_.begin_send(coroutine, dest_id_, message_, &reply_, nullptr, timeout_);
+        }
+        Reply await_resume() { return std::move(reply_); }
+
+    private:
+        CoroutineThreadWrapper& owner_;
+        int dest_id_;
+        ThreadWrapperMessage message_;
+        Duration timeout_;
+        Reply reply_;
+    };
+
+    class SendAwaiter
+    {
+    public:
+        SendAwaiter(CoroutineThreadWrapper& owner, int dest_id, ThreadWrapperMessage message)
+            : owner_(owner), dest_id_(dest_id), message_(std::move(message)) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(HandlerTask::Handle coroutine)
+        {
+            return owner_.begin_send(coroutine, dest_id_, message_, nullptr, &result_, Duration::zero());
+        }
+        ThreadWrapperError await_resume() const noexcept { return result_; }
+
+    private:
+        CoroutineThreadWrapper& owner_;
+        int dest_id_;
+        ThreadWrapperMessage message_;
+        ThreadWrapperError result_ = ThreadWrapperError::OK;
+    };
+
+    class SleepAwaiter
+    {
+    public:
+        SleepAwaiter(CoroutineThreadWrapper& owner, Duration delay) : owner_(owner), delay_(delay) {}
+
+        bool await_ready() const noexcept { return delay_ <= Duration::zero(); }
+        bool await_suspend(HandlerTask::Handle coroutine) { return owner_.begin_sleep(coroutine, delay_); }
+        void await_resume() const noexcept {}
+
+    private:
+        CoroutineThreadWrapper& owner_;
+        Duration delay_;
+    };
+
+    /**
+     * @brief Sends a request and suspends until the destination answers with
+     * ThreadWrapperApp::reply(), or until `timeout` (zero: no timeout). Waits
+     * for room if the destination is full.
+     */
+    template<typename T>
+    RequestAwaiter request(int dest_id, int msg_id, T&& value, Duration timeout = Duration::zero())
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return RequestAwaiter(*this, dest_id, std::move(message), timeout);
+    }
+
+    /// @brief Sends a message, suspending while the destination queue is full. Yields the send result.
+    template<typename T>
+    SendAwaiter send_when_ready(int dest_id, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return SendAwaiter(*this, dest_id, std::move(message));
+    }
+
+    /// @brief Suspends for `delay` (timer wheel resolution, 1 ms).
+    SleepAwaiter sleep_for(Duration delay) { return SleepAwaiter(*this, delay); }
+
+    /// @brief Answers a request this thread received; see ThreadWrapperApp::reply().
+    template<typename T>
+    ThreadWrapperError reply(const ThreadWrapperMessage& request, int msg_id, T&& value)
+    {
+        return ThreadWrapperApp::get_instance().reply(request, msg_id, std::forward<T>(value));
+    }
+
+private:
+    // A suspended handler and the event it waits for.
+    struct Wait {
+        HandlerTask::Handle coroutine;
+        Reply* reply = nullptr;               // Set for request().
+        ThreadWrapperError* result = nullptr; // Set for send_when_ready().
+        ThreadWrapperMessage* pending_send = nullptr; // Still waiting for room; owned by the awaiter.
+        int dest_id = 0;
+        TimerHandle timeout;                  // Request timeout, cancelled when the reply arrives.
+    };
+    using WaitMap = std::unordered_map<uint32_t, Wait>;
+
+    bool begin_send(HandlerTask::Handle coroutine, int dest_id, ThreadWrapperMessage& message,
+                    Reply* reply, ThreadWrapperError* result, Duration timeout);
+    bool begin_sleep(HandlerTask::Handle coroutine, Duration delay);
+    ThreadWrapperError on_reply(ThreadWrapperMessage& message);
+    ThreadWrapperError resume(WaitMap::iterator it);
+    ThreadWrapperError run(HandlerTask::Handle coroutine);
+    void wait_for_space(uint32_t id, int dest_id, MessagePriority priority);
+    uint32_t next_correlation_id();
+
+    WaitMap waits_;
+    uint32_t last_correlation_id_ = 0;
+};
+
+#endif // COROUTINE_THREAD_WRAPPER_HPP
@@ -0,0 +1,18 @@
+#ifndef CPU_RELAX_HPP
+#define CPU_RELAX_HPP
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/// @brief Spin-wait hint: lets a sibling hyperthread run and saves power, without a syscall.
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+#endif // CPU_RELAX_HPP
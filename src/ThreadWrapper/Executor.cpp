@@ -0,0 +1,138 @@
+#include "ThreadWrapper/Executor.hpp"
+#include "ThreadWrapper/ThreadWrapperMgr.hpp"
+#include "ThreadWrapper/Tracer.hpp"
+
+namespace {
+// The executor and worker index of the calling thread, if it is a pool worker.
+thread_local Executor* tls_executor = nullptr;
+thread_local uint32_t tls_worker_index = 0;
+
+// A worker checks the injection queue before its own deque every this many
+// slices, so actors that keep waking each other locally cannot starve it.
+constexpr uint32_t INJECT_CHECK_INTERVAL = 61;
+}
+
+Executor::Executor(uint32_t workers)
+{
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+    }
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    workers_.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Start the threads only once every deque exists: workers steal from each other.
+    for (uint32_t i = 0; i < workers; ++i) {
+        workers_[i]->thread = std::thread([this, i]() { this->worker_loop(i); });
+    }
+}
+
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        stopping_.store(true, std::memory_order_seq_cst);
+        park_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void Executor::submit(ThreadWrapperMgr* mgr, bool yielded)
+{
+    if (!yielded && tls_executor == this) {
+        workers_[tls_worker_index]->deque.push(mgr);
+    } else {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        inject_queue_.push_back(mgr);
+    }
+    wake_one();
+}
+
+void Executor::wake_one()
+{
+    // Pairs with the increment of sleepers_ in worker_loop(): either the
+    // parking worker's re-check sees the new work, or we see it parked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+void Executor::worker_loop(uint32_t index)
+{
+    tls_executor = this;
+    tls_worker_index = index;
+    Tracer::set_thread_name("executor-" + std::to_string(index));
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (ThreadWrapperMgr* mgr = find_work(index)) {
+            mgr->run_slice();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        if (!stopping_.load(std::memory_order_seq_cst) && !has_work()) {
+            park_cv_.wait(lock);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    tls_executor = nullptr;
+}
+
+ThreadWrapperMgr* Executor::find_work(uint32_t index)
+{
+    static thread_local uint32_t tick = 0;
+    ThreadWrapperMgr* mgr = nullptr;
+    Worker& self = *workers_[index];
+
+    bool inject_first = ++tick % INJECT_CHECK_INTERVAL == 0;
+    if (!inject_first && self.deque.pop(mgr)) {
+        return mgr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (!inject_queue_.empty()) {
+            mgr = inject_queue_.front();
+            inject_queue_.pop_front();
+            return mgr;
+        }
+    }
+    if (inject_first && self.deque.pop(mgr)) {
+        return mgr;
+    }
+
+    const uint32_t count = worker_count();
+    for (uint32_t i = 1; i < count; ++i) {
+        if (workers_[(index + i) % count]->deque.steal(mgr)) {
+            return mgr;
+        }
+    }
+    return nullptr;
+}
+
+bool Executor::has_work() const
+{
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (!inject_queue_.empty()) {
+            return true;
+        }
+    }
+    for (const auto& worker : workers_) {
+        if (!worker->deque.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
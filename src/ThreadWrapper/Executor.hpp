@@ -0,0 +1,75 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadWrapper/WorkStealingDeque.hpp"
+
+class ThreadWrapperMgr;
+
+/**
+ * @class Executor
+ * @brief A fixed pool of worker threads that runs POOLED wrappers as actors.
+ *
+ * A pooled ThreadWrapperMgr is submitted whenever its mailbox goes from idle
+ * to non-empty and runs one slice (a few batches) on whichever worker picks
+ * it up. The manager's own "scheduled" flag guarantees that it is queued at
+ * most once, so its process() never runs concurrently with itself.
+ *
+ * Each worker owns a work-stealing deque. Work submitted from a worker goes
+ * to its own deque (the woken actor is likely to touch data that is still in
+ * cache); work submitted from other threads, and actors that used up their
+ * slice, go to a shared FIFO injection queue so nobody starves. Idle workers
+ * steal from each other and park when there is nothing left.
+ *
+ * Pooled wrappers share the workers, so a process() that blocks (for example
+ * a send_message_wait() to a full pooled mailbox) holds a worker hostage.
+ */
+class Executor
+{
+public:
+    /// @param workers Number of worker threads; 0 means one per hardware thread.
+    explicit Executor(uint32_t workers = 0);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Queues `mgr` to run one slice. Safe from any thread.
+     * @param yielded true when an actor re-queues itself after using up its slice.
+     */
+    void submit(ThreadWrapperMgr* mgr, bool yielded = false);
+
+    uint32_t worker_count() const noexcept { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+    struct Worker {
+        WorkStealingDeque<ThreadWrapperMgr*> deque;
+        std::thread thread;
+    };
+
+    void worker_loop(uint32_t index);
+    ThreadWrapperMgr* find_work(uint32_t index);
+    bool has_work() const;
+    void wake_one();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    mutable std::mutex inject_mutex_;
+    std::deque<ThreadWrapperMgr*> inject_queue_;
+
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+#endif // EXECUTOR_HPP
@@ -0,0 +1,58 @@
+#ifndef EXTERNAL_MAILBOX_HPP
+#define EXTERNAL_MAILBOX_HPP
+
+#include <chrono>
+#include <string>
+#include "ThreadWrapper/ThreadWrapperMgr.hpp"
+
+/**
+ * @class ExternalMailbox
+ * @brief The mailbox of a thread the framework does not run: the main thread,
+ * or a thread the application created itself.
+ *
+ * It is registered under a name and thread ID like any wrapper, so workers
+ * send to it (and reply to requests made through it) with the usual calls;
+ * the owning thread takes messages out by polling or blocking here. Only one
+ * thread may receive from a mailbox at a time. A STOP message means the
+ * application is stopping. Obtained from ThreadWrapperApp::main_mailbox() or
+ * ThreadWrapperApp::create_external_mailbox().
+ */
+class ExternalMailbox
+{
+public:
+    ExternalMailbox(ThreadWrapperMgr& mgr, int id) : mgr_(mgr), id_(id) {}
+
+    ExternalMailbox(const ExternalMailbox&) = delete;
+    ExternalMailbox& operator=(const ExternalMailbox&) = delete;
+
+    /// @brief Thread ID to send to, and to put in reply_to.
+    int id() const noexcept { return id_; }
+    const std::string& name() const noexcept { return mgr_.get_thread_name(); }
+
+    /// @brief Takes a message if one is queued, without blocking.
+    bool try_receive(ThreadWrapperMessage& message)
+    {
+        return mgr_.receive_message(message, std::chrono::steady_clock::time_point::min());
+    }
+
+    /// @brief Blocks until a message arrives.
+    void receive(ThreadWrapperMessage& message)
+    {
+        mgr_.receive_message(message, std::chrono::steady_clock::time_point::max());
+    }
+
+    /// @brief Blocks for at most `timeout`. @return false if nothing arrived.
+    bool receive_for(ThreadWrapperMessage& message, std::chrono::steady_clock::duration timeout)
+    {
+        return mgr_.receive_message(message, std::chrono::steady_clock::now() + timeout);
+    }
+
+    /// @brief Number of queued messages.
+    uint32_t size() const { return mgr_.get_queue_size(); }
+
+private:
+    ThreadWrapperMgr& mgr_;
+    const int id_;
+};
+
+#endif // EXTERNAL_MAILBOX_HPP
@@ -0,0 +1,90 @@
+#include "ThreadWrapper/FdEventLoop.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace {
+uint32_t to_epoll_events(FdEvents events)
+{
+    uint32_t mask = 0;
+    if (static_cast<uint32_t>(events) & static_cast<uint32_t>(FdEvents::READABLE)) {
+        mask |= EPOLLIN;
+    }
+    if (static_cast<uint32_t>(events) & static_cast<uint32_t>(FdEvents::WRITABLE)) {
+        mask |= EPOLLOUT;
+    }
+    return mask;
+}
+}
+
+FdEventLoop::FdEventLoop() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+{
+}
+
+FdEventLoop::~FdEventLoop()
+{
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+ThreadWrapperError FdEventLoop::set_wake_fd(int fd)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return ThreadWrapperError::ERROR;
+    }
+    wake_fd_ = fd;
+    return ThreadWrapperError::OK;
+}
+
+ThreadWrapperError FdEventLoop::watch(int fd, FdEvents events)
+{
+    if (epoll_fd_ < 0 || fd < 0 || fd == wake_fd_) {
+        return ThreadWrapperError::INVALID_ARGS;
+    }
+    epoll_event event{};
+    event.events = to_epoll_events(events);
+    event.data.fd = fd;
+    const bool known = watching(fd);
+    if (epoll_ctl(epoll_fd_, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) != 0) {
+        return ThreadWrapperError::ERROR;
+    }
+    watched_[fd] = events;
+    return ThreadWrapperError::OK;
+}
+
+ThreadWrapperError FdEventLoop::unwatch(int fd)
+{
+    auto it = watched_.find(fd);
+    if (it == watched_.end()) {
+        return ThreadWrapperError::INVALID_ARGS;
+    }
+    watched_.erase(it);
+    // Fails harmlessly (EBADF) if the fd was closed first, which already removed it.
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    return ThreadWrapperError::OK;
+}
+
+int FdEventLoop::wait(Ready* ready, int timeout_ms)
+{
+    epoll_event events[MAX_READY];
+    int count = epoll_wait(epoll_fd_, events, MAX_READY, timeout_ms);
+    if (count < 0) {
+        return 0; // EINTR: the caller re-checks the mailbox and waits again.
+    }
+
+    int out = 0;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.fd == wake_fd_) {
+            continue;
+        }
+        const uint32_t mask = events[i].events;
+        ready[out++] = Ready{events[i].data.fd,
+                             (mask & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0,
+                             (mask & EPOLLOUT) != 0};
+    }
+    return out;
+}
@@ -0,0 +1,75 @@
+#ifndef FD_EVENT_LOOP_HPP
+#define FD_EVENT_LOOP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "ThreadWrapper/ThreadWrapperError.hpp"
+
+/**
+ * @enum FdEvents
+ * @brief Readiness a ThreadWrapper asks to be told about for one file descriptor.
+ */
+enum class FdEvents : uint32_t {
+    READABLE = 1,
+    WRITABLE = 2,
+    READ_WRITE = 3,
+};
+
+/**
+ * @class FdEventLoop
+ * @brief The epoll instance behind a worker with ThreadWrapperParam::fd_events (Linux).
+ *
+ * Holds the mailbox's eventfd and whatever descriptors the wrapper watches,
+ * so the worker blocks in one epoll_wait() for both. Watches are level
+ * triggered: a descriptor stays readable (or writable) until the wrapper
+ * drains (or fills) it, so a WRITABLE watch should be dropped once there is
+ * nothing left to write. Used by the worker thread only.
+ */
+class FdEventLoop
+{
+public:
+    /// @brief One ready descriptor; `readable` also covers hang-up and error.
+    struct Ready {
+        int fd;
+        bool readable;
+        bool writable;
+    };
+
+    static constexpr int MAX_READY = 64;
+
+    FdEventLoop();
+    ~FdEventLoop();
+
+    FdEventLoop(const FdEventLoop&) = delete;
+    FdEventLoop& operator=(const FdEventLoop&) = delete;
+
+    /// @brief False if the epoll instance could not be created.
+    bool valid() const noexcept { return epoll_fd_ >= 0; }
+
+    /// @brief Registers the mailbox's eventfd, whose readiness only means "look at the mailbox".
+    ThreadWrapperError set_wake_fd(int fd);
+
+    /// @brief Starts watching `fd`, or changes the events of an fd already watched.
+    ThreadWrapperError watch(int fd, FdEvents events);
+    /// @brief Stops watching `fd`. The caller still owns and closes it.
+    ThreadWrapperError unwatch(int fd);
+
+    bool watching(int fd) const { return watched_.count(fd) != 0; }
+    size_t watch_count() const noexcept { return watched_.size(); }
+
+    /**
+     * @brief Waits up to `timeout_ms` (-1: forever, 0: just poll) for readiness.
+     * Wake-fd readiness is left out of `ready`.
+     * @return The number of entries written to `ready` (at most MAX_READY).
+     */
+    int wait(Ready* ready, int timeout_ms);
+
+private:
+    int epoll_fd_;
+    int wake_fd_ = -1;
+    std::unordered_map<int, FdEvents> watched_;
+};
+
+#endif // FD_EVENT_LOOP_HPP
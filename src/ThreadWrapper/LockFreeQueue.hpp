@@ -0,0 +1,144 @@
+#ifndef LOCK_FREE_QUEUE_HPP
+#define LOCK_FREE_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ThreadWrapper/Placement.hpp"
+
+// Size of a destructive-interference unit. Kept as a literal because
+// std::hardware_destructive_interference_size is not reliably available.
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @class LockFreeQueue
+ * @brief A bounded multi-producer/single-consumer ring buffer.
+ *
+ * Each cell carries a sequence number (Vyukov's bounded queue): producers
+ * claim a slot with a CAS on the tail and publish it by bumping the cell's
+ * sequence, the single consumer reads cells in order without any RMW.
+ * Head and tail live on separate cache lines so producers and the consumer
+ * do not false-share. The queue never blocks; waiting is left to the caller.
+ *
+ * Capacity semantics match ThreadSafeQueue: push() fails once `capacity`
+ * items are queued, and out-of-range capacities fall back to the default.
+ */
+template<typename T>
+class LockFreeQueue {
+public:
+    /// @param numa_node NUMA node to place the ring on; -1 for the default allocator.
+    explicit LockFreeQueue(uint32_t capacity, int numa_node = -1)
+        : cells_(clamp_capacity(capacity), NumaAllocator<Cell>(numa_node)),
+          queue_capacity_(clamp_capacity(capacity))
+    {
+        for (uint32_t i = 0; i < queue_capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue() : LockFreeQueue(DEFAULT_QUEUE_CAPACITY) {}
+
+    ~LockFreeQueue() = default;
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    /**
+     * @brief Pushes a value if there is capacity. Safe from any number of threads.
+     * @return true on success, false if the queue is full.
+     */
+    bool push(T value)
+    {
+        return try_push(value);
+    }
+
+    /**
+     * @brief Like push(), but only moves from `value` if the push succeeds.
+     * @return true on success, false if the queue is full (value is left intact).
+     */
+    bool try_push(T& value)
+    {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos % queue_capacity_];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Queue is full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pops a value without blocking. Must only be called by the single consumer.
+     * @return true on success, false if the queue was empty.
+     */
+    bool try_pop(T& value)
+    {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos % queue_capacity_];
+        uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(pos + queue_capacity_, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// @brief Checks if the queue is empty. Approximate while producers are active.
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /// @brief Returns the current number of items in the queue. Approximate while producers are active.
+    uint32_t size() const
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? static_cast<uint32_t>(tail - head) : 0;
+    }
+
+    uint32_t capacity() const noexcept { return queue_capacity_; }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        T value{};
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0};
+    static uint32_t clamp_capacity(uint32_t capacity)
+    {
+        if (capacity >= MIN_QUEUE_CAPACITY && capacity <= MAX_QUEUE_CAPACITY) {
+            return capacity;
+        }
+        return DEFAULT_QUEUE_CAPACITY;
+    }
+
+    alignas(CACHE_LINE_SIZE) std::vector<Cell, NumaAllocator<Cell>> cells_;
+    uint32_t queue_capacity_;
+
+    static constexpr uint32_t MIN_QUEUE_CAPACITY = 1;
+    static constexpr uint32_t MAX_QUEUE_CAPACITY = 10000;
+    static constexpr uint32_t DEFAULT_QUEUE_CAPACITY = 256;
+};
+
+#endif /* LOCK_FREE_QUEUE_HPP */
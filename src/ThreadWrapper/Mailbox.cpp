@@ -0,0 +1,447 @@
+#include "ThreadWrapper/Mailbox.hpp"
+#include <algorithm>
+#include <thread>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "ThreadWrapper/CpuRelax.hpp"
+
+namespace {
+constexpr uint32_t SPIN_CLOCK_INTERVAL = 64; // Pauses between clock reads while spinning.
+constexpr uint32_t YIELD_ROUNDS = 8;         // Yields after the spin, before parking.
+constexpr uint64_t MIN_SPIN_NS = 500;        // Floor, so the budget can grow again.
+
+inline uint64_t steady_ns() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+Mailbox::Lane::Lane(uint32_t capacity, MailboxType type, int numa_node)
+{
+    if (type == MailboxType::MUTEX) {
+        locked_queue = std::make_unique<ThreadSafeQueue<Item>>(capacity, numa_node);
+    } else {
+        lock_free_queue = std::make_unique<LockFreeQueue<Item>>(capacity, numa_node);
+    }
+}
+
+bool Mailbox::Lane::try_push(Item& item)
+{
+    return locked_queue ? locked_queue->try_push(item) : lock_free_queue->try_push(item);
+}
+
+uint32_t Mailbox::Lane::try_pop_batch(Item* out, uint32_t max_items)
+{
+    if (locked_queue) {
+        return locked_queue->try_pop_batch(out, max_items);
+    }
+    uint32_t count = 0;
+    while (count < max_items && lock_free_queue->try_pop(out[count])) {
+        ++count;
+    }
+    return count;
+}
+
+uint32_t Mailbox::Lane::size() const
+{
+    return locked_queue ? locked_queue->size() : lock_free_queue->size();
+}
+
+uint32_t Mailbox::Lane::approx_size() const noexcept
+{
+    // Lock-free: the ring's own size() is already a pair of atomic loads.
+    return locked_queue ? locked_queue->approx_size() : lock_free_queue->size();
+}
+
+uint32_t Mailbox::Lane::capacity() const
+{
+    return locked_queue ? locked_queue->capacity() : lock_free_queue->capacity();
+}
+
+Mailbox::Mailbox(uint32_t capacity, MailboxType type, int numa_node,
+                 uint32_t high_capacity, uint32_t high_weight)
+    : type_(type),
+      normal_lane_(capacity, type, numa_node),
+      high_lane_(high_capacity, type, numa_node),
+      high_weight_(high_weight)
+{
+}
+
+Mailbox::~Mailbox()
+{
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+}
+
+bool Mailbox::push(Item item)
+{
+    return try_push(lane_for(item), item);
+}
+
+bool Mailbox::try_push(Lane& lane, Item& item)
+{
+    if (closed_.load(std::memory_order_acquire) || !lane.try_push(item)) {
+        return false;
+    }
+    wake_consumer();
+    return true;
+}
+
+void Mailbox::wake_consumer()
+{
+    // Pairs with the fence in park_until_not_empty(): either the consumer sees the
+    // new item on its re-check, or we see it parked and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_parked_.load(std::memory_order_relaxed)) {
+        if (wake_fd_ >= 0) {
+            const uint64_t one = 1;
+            ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+            (void)written; // Only fails if the counter is saturated, and then it is already readable.
+            return;
+        }
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+int Mailbox::enable_wake_fd()
+{
+    if (wake_fd_ < 0) {
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    return wake_fd_;
+}
+
+bool Mailbox::begin_fd_wait()
+{
+    // Same handshake as park_until_not_empty(), with the eventfd in place of the condition variable.
+    consumer_parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!empty()) {
+        consumer_parked_.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void Mailbox::end_fd_wait()
+{
+    consumer_parked_.store(false, std::memory_order_relaxed);
+    uint64_t count;
+    ssize_t drained = ::read(wake_fd_, &count, sizeof(count));
+    (void)drained; // EAGAIN when nobody signalled: woken by another descriptor.
+}
+
+bool Mailbox::push_wait(Item item, std::chrono::steady_clock::time_point deadline)
+{
+    Lane& lane = lane_for(item);
+    if (try_push(lane, item)) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(lane.space_mutex);
+    lane.full_waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool pushed = false;
+    while (!closed_.load(std::memory_order_acquire)) {
+        // Re-check under the lock: notify_space() takes the same lock, so a
+        // slot freed between this check and the wait cannot be missed.
+        if (try_push(lane, item)) {
+            pushed = true;
+            break;
+        }
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            lane.space_cv.wait(lock);
+        } else if (lane.space_cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+            pushed = !closed_.load(std::memory_order_acquire) && try_push(lane, item);
+            break;
+        }
+    }
+    lane.full_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return pushed;
+}
+
+bool Mailbox::notify_when_space(MessagePriority priority, std::function<void()> callback)
+{
+    Lane& lane = lane_for(priority);
+    std::lock_guard<std::mutex> lock(lane.space_mutex);
+    if (closed_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    // Same handshake as push_wait(): count ourselves in, then re-check for room.
+    lane.full_waiters.fetch_add(1, std::memory_order_seq_cst);
+    if (lane.size() < lane.capacity()) {
+        lane.full_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    lane.space_callbacks.push_back(std::move(callback));
+    return true;
+}
+
+void Mailbox::request_stop(bool drain, std::chrono::steady_clock::time_point deadline)
+{
+    if (drain) {
+        const int64_t ticks = deadline.time_since_epoch().count();
+        int64_t current = drain_deadline_.load(std::memory_order_relaxed);
+        // Keep the earliest deadline of all requests; a failed exchange reloads `current`.
+        while (ticks < current &&
+               !drain_deadline_.compare_exchange_weak(current, ticks, std::memory_order_relaxed)) {
+        }
+        uint8_t expected = NOT_STOPPING;
+        stop_state_.compare_exchange_strong(expected, STOP_AFTER_DRAIN, std::memory_order_release);
+    } else {
+        stop_state_.store(STOP_NOW, std::memory_order_release);
+    }
+    wake_consumer();
+}
+
+bool Mailbox::stop_due(uint8_t state) const
+{
+    if (state != STOP_AFTER_DRAIN) {
+        return state == STOP_NOW;
+    }
+    const int64_t deadline = drain_deadline_.load(std::memory_order_relaxed);
+    return deadline != INT64_MAX && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline;
+}
+
+void Mailbox::close()
+{
+    closed_.store(true, std::memory_order_release);
+    // Pairs with the fence in wake_consumer(): a sender whose push lands after this
+    // either sees closed() afterwards, or the owner's clear() sees its item.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Lane* lane : {&normal_lane_, &high_lane_}) {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(lane->space_mutex);
+            lane->space_cv.notify_all();
+            lane->full_waiters.fetch_sub(static_cast<uint32_t>(lane->space_callbacks.size()),
+                                         std::memory_order_relaxed);
+            callbacks.swap(lane->space_callbacks);
+        }
+        for (auto& callback : callbacks) {
+            callback(); // Their retry will find the mailbox closed.
+        }
+    }
+}
+
+uint32_t Mailbox::clear(const std::function<void(Item&)>& on_drop)
+{
+    static constexpr uint32_t CHUNK = 16;
+    Item dropped[CHUNK];
+    uint32_t total = 0;
+    for (Lane* lane : {&high_lane_, &normal_lane_}) {
+        uint32_t count;
+        while ((count = lane->try_pop_batch(dropped, CHUNK)) > 0) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (on_drop) {
+                    on_drop(dropped[i]);
+                }
+                dropped[i].clear_payload();
+            }
+            total += count;
+        }
+    }
+    return total;
+}
+
+void Mailbox::notify_space(Lane& lane, uint32_t freed_slots)
+{
+    // Pairs with the seq_cst increment in push_wait(): either the waiter's
+    // re-check sees the freed slot, or we see the waiter and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lane.full_waiters.load(std::memory_order_relaxed) != 0) {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(lane.space_mutex);
+            if (freed_slots == 1) {
+                lane.space_cv.notify_one();
+            } else {
+                lane.space_cv.notify_all();
+            }
+            if (!lane.space_callbacks.empty()) {
+                lane.full_waiters.fetch_sub(static_cast<uint32_t>(lane.space_callbacks.size()),
+                                            std::memory_order_relaxed);
+                callbacks.swap(lane.space_callbacks);
+            }
+        }
+        // Outside the lock: a callback typically sends a message of its own.
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+}
+
+bool Mailbox::try_pop(Item& item)
+{
+    return try_pop_batch(&item, 1) == 1;
+}
+
+void Mailbox::wait_and_pop(Item& item)
+{
+    wait_and_pop_batch(&item, 1);
+}
+
+uint32_t Mailbox::wait_and_pop_batch(Item* out, uint32_t max_items)
+{
+    if (max_items == 0) {
+        return 0;
+    }
+    while (true) {
+        uint32_t count = try_pop_batch(out, max_items);
+        if (count > 0) {
+            return count;
+        }
+        if (wait_policy_ == WaitPolicy::SPIN_THEN_PARK && spin_until_not_empty()) {
+            continue;
+        }
+        park_until_not_empty(std::chrono::steady_clock::time_point::max());
+    }
+}
+
+bool Mailbox::wait_and_pop_until(Item& item, std::chrono::steady_clock::time_point deadline)
+{
+    while (try_pop_batch(&item, 1) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        park_until_not_empty(deadline);
+    }
+    return true;
+}
+
+void Mailbox::set_wait_policy(WaitPolicy policy, std::chrono::nanoseconds max_spin)
+{
+    wait_policy_ = policy;
+    max_spin_ns_ = policy == WaitPolicy::SPIN_THEN_PARK && max_spin.count() > 0
+        ? static_cast<uint64_t>(max_spin.count()) : 0;
+    spin_budget_ns_ = max_spin_ns_;
+}
+
+bool Mailbox::spin_until_not_empty()
+{
+    // With a single CPU the producer cannot run while we spin; only yielding helps.
+    static const bool can_spin = std::thread::hardware_concurrency() > 1;
+
+    const uint64_t start = steady_ns();
+    const uint64_t budget = spin_budget_ns_;
+    if (can_spin && budget > 0) {
+        for (uint32_t i = 1; ; ++i) {
+            cpu_relax();
+            if (!probably_empty()) {
+                adapt_spin_budget(steady_ns() - start);
+                return true;
+            }
+            if (i % SPIN_CLOCK_INTERVAL == 0 && steady_ns() - start >= budget) {
+                break;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < YIELD_ROUNDS; ++i) {
+        std::this_thread::yield();
+        if (!probably_empty()) {
+            adapt_spin_budget(steady_ns() - start);
+            return true;
+        }
+    }
+    adapt_spin_budget(UINT64_MAX);
+    return false;
+}
+
+void Mailbox::adapt_spin_budget(uint64_t gap_ns)
+{
+    uint64_t budget = spin_budget_ns_;
+    if (gap_ns <= max_spin_ns_) {
+        // Aim at twice the observed gap, moving an eighth of the way per wait.
+        const uint64_t target = std::min(gap_ns * 2, max_spin_ns_);
+        budget = target > budget ? budget + (target - budget) / 8 : budget - (budget - target) / 8;
+    } else {
+        budget -= budget / 4; // The gap outlasted any spin we would allow: back off.
+    }
+    spin_budget_ns_ = std::max(budget, std::min(MIN_SPIN_NS, max_spin_ns_));
+}
+
+uint32_t Mailbox::try_pop_batch(Item* out, uint32_t max_items)
+{
+    if (max_items == 0) {
+        return 0;
+    }
+    const uint8_t stop = stop_state_.load(std::memory_order_acquire);
+    if (stop != NOT_STOPPING && stop_due(stop)) {
+        return pop_stop(out);
+    }
+
+    // Under a weight, HIGH may only run `high_weight_` messages ahead of a waiting NORMAL one.
+    uint32_t high_quota = max_items;
+    if (high_weight_ > 0) {
+        high_quota = high_streak_ < high_weight_ ? std::min(max_items, high_weight_ - high_streak_) : 0;
+    }
+
+    uint32_t high = high_lane_.try_pop_batch(out, high_quota);
+    uint32_t normal = normal_lane_.try_pop_batch(out + high, max_items - high);
+    if (normal == 0 && high < max_items && high_weight_ > 0) {
+        // No NORMAL message is waiting, so the quota does not apply.
+        high += high_lane_.try_pop_batch(out + high, max_items - high);
+    }
+    high_streak_ = normal > 0 ? 0 : high_streak_ + high;
+    if (high + normal == 0 && stop == STOP_AFTER_DRAIN) {
+        return pop_stop(out); // Drained.
+    }
+
+    if (high > 0) {
+        notify_space(high_lane_, high);
+    }
+    if (normal > 0) {
+        notify_space(normal_lane_, normal);
+    }
+    return high + normal;
+}
+
+uint32_t Mailbox::pop_stop(Item* out)
+{
+    out[0] = Item();
+    out[0].kind = MessageKind::STOP;
+    out[0].priority = MessagePriority::HIGH;
+    return 1;
+}
+
+void Mailbox::park_until_not_empty(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    consumer_parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty()) {
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            park_cv_.wait(lock);
+        } else {
+            park_cv_.wait_until(lock, deadline);
+        }
+    }
+    consumer_parked_.store(false, std::memory_order_relaxed);
+}
+
+uint32_t Mailbox::size() const
+{
+    return normal_lane_.size() + high_lane_.size();
+}
+
+uint32_t Mailbox::approx_size() const noexcept
+{
+    return normal_lane_.approx_size() + high_lane_.approx_size();
+}
+
+bool Mailbox::empty() const
+{
+    return stop_state_.load(std::memory_order_acquire) == NOT_STOPPING &&
+           normal_lane_.size() == 0 && high_lane_.size() == 0;
+}
+
+bool Mailbox::probably_empty() const noexcept
+{
+    // Polled by a spinning consumer, so it must not take the MUTEX lanes' locks
+    // and contend with the very senders it waits for.
+    return stop_state_.load(std::memory_order_relaxed) == NOT_STOPPING &&
+           normal_lane_.approx_size() == 0 && high_lane_.approx_size() == 0;
+}
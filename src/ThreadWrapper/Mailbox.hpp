@@ -0,0 +1,223 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+#include "ThreadWrapper/ThreadSafeQueue.hpp"
+#include "ThreadWrapper/LockFreeQueue.hpp"
+#include "ThreadWrapper/ThreadWrapper.hpp"
+#include "ThreadWrapper/ThreadWrapperMessage.hpp"
+
+/**
+ * @class Mailbox
+ * @brief The message queue owned by a ThreadWrapperMgr.
+ *
+ * Many producers, one consumer (the worker thread, or for a pooled wrapper
+ * whichever executor worker is running it). Envelopes are stored
+ * by value in storage allocated up front, so steady-state traffic performs
+ * no heap allocation in the mailbox. The backing store is
+ * either the mutex-based ThreadSafeQueue or the lock-free LockFreeQueue,
+ * selected per thread through ThreadWrapperParam::mailbox_type.
+ *
+ * There are two lanes, picked by ThreadWrapperMessage::priority. HIGH
+ * messages have their own (small) capacity, so a full data backlog never
+ * rejects them, and are dequeued first: strictly, or with a weight that lets
+ * a NORMAL message through after every `high_weight` HIGH ones. The stop
+ * request is not queued at all but raised as a flag, so it always succeeds:
+ * it either overtakes both lanes, or lets the consumer drain them first and
+ * takes effect once they are empty or its deadline has passed.
+ *
+ * The consumer waits on both lanes at once; producers only touch the park
+ * mutex when the consumer has announced that it is about to sleep. Under
+ * WaitPolicy::SPIN_THEN_PARK the consumer first spins and yields without
+ * announcing anything, so a message sent meanwhile costs its producer no
+ * notify at all. The spin time follows how long the mailbox has recently
+ * stayed empty: it grows toward twice the observed gap while spinning pays
+ * off, and shrinks each time the consumer parks anyway.
+ *
+ * Senders that want backpressure instead of ENQUEUE_FAILED use push_wait(),
+ * which parks on the lane's "not full" condition that the consumer signals
+ * each time it frees a slot, and only if a sender is actually waiting.
+ */
+class Mailbox
+{
+public:
+    using Item = ThreadWrapperMessage;
+
+    static constexpr uint32_t DEFAULT_HIGH_CAPACITY = 64;
+
+    /**
+     * @param capacity Capacity of the NORMAL lane.
+     * @param numa_node NUMA node to allocate the rings on; -1 for the default allocator.
+     * @param high_capacity Capacity of the HIGH lane.
+     * @param high_weight 0 for strict priority; otherwise the number of HIGH
+     *        messages dequeued in a row before a waiting NORMAL one gets a turn.
+     */
+    Mailbox(uint32_t capacity, MailboxType type, int numa_node = -1,
+            uint32_t high_capacity = DEFAULT_HIGH_CAPACITY, uint32_t high_weight = 0);
+
+    ~Mailbox();
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    /// @brief Enqueues an item in the lane of its priority. Returns false if that lane is full.
+    bool push(Item item);
+
+    /**
+     * @brief Enqueues an item, blocking while its lane is full.
+     * @param deadline Give up at this point in time; time_point::max() waits indefinitely.
+     * @return true on success, false on timeout or if the mailbox was closed.
+     */
+    bool push_wait(Item item, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Runs `callback` once the lane of `priority` frees a slot (or the mailbox
+     * closes), on the consumer's thread. A non-blocking alternative to push_wait().
+     * @return false, without keeping the callback, if the lane has room already or the mailbox is closed.
+     */
+    bool notify_when_space(MessagePriority priority, std::function<void()> callback);
+
+    /**
+     * @brief Asks the consumer to stop. Never fails. Without `drain` the next pop
+     * returns a STOP envelope; with it, pops go on returning messages and yield
+     * STOP once both lanes are empty or `deadline` has passed. A second request
+     * can only make the first one stricter.
+     */
+    void request_stop(bool drain = false,
+                      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    /// @brief Marks the mailbox as having no consumer and releases all blocked senders.
+    /// Pushes fail from then on.
+    void close();
+
+    /**
+     * @brief Whether close() was called. Checked after a successful push, it tells
+     * a sender that raced with close() that its item may have missed the final clear().
+     */
+    bool closed() const noexcept { return closed_.load(std::memory_order_relaxed); }
+
+    /// @brief Drops every queued message, passing each to `on_drop` first if given.
+    /// Consumer only. @return How many were dropped.
+    uint32_t clear(const std::function<void(Item&)>& on_drop = nullptr);
+
+    /// @brief Dequeues an item without blocking. Consumer only.
+    bool try_pop(Item& item);
+
+    /// @brief Blocks until an item is available and dequeues it. Consumer only.
+    void wait_and_pop(Item& item);
+
+    /**
+     * @brief Like wait_and_pop(), but gives up at `deadline`. Consumer only.
+     * @return false if nothing arrived in time.
+     */
+    bool wait_and_pop_until(Item& item, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Blocks until at least one item is available, then dequeues up to
+     * `max_items` items at once (one lock hold per lane on the mutex backend). Consumer only.
+     * @return The number of items written to `out`.
+     */
+    uint32_t wait_and_pop_batch(Item* out, uint32_t max_items);
+
+    /// @brief Dequeues up to `max_items` items without blocking. Consumer only. @return the count.
+    uint32_t try_pop_batch(Item* out, uint32_t max_items);
+
+    /// @brief Number of queued messages in both lanes.
+    uint32_t size() const;
+
+    /// @brief Like size(), but without taking any lock; may lag concurrent pushes and pops.
+    uint32_t approx_size() const noexcept;
+
+    /// @brief True if there is nothing to dequeue: both lanes empty and no stop requested.
+    bool empty() const;
+
+    MailboxType type() const noexcept { return type_; }
+
+    /**
+     * @brief Wakes the consumer through an eventfd instead of the condition variable,
+     * so it can wait in epoll together with other descriptors. Call before the consumer starts.
+     * @return The eventfd (owned by the mailbox), or -1 if it could not be created.
+     */
+    int enable_wake_fd();
+
+    /**
+     * @brief Announces that the consumer is about to block on the wake fd. Consumer only.
+     * @return true if the mailbox is still empty, so the caller may block; false if it must pop first.
+     */
+    bool begin_fd_wait();
+    /// @brief Ends a wait begun by begin_fd_wait() and resets the wake fd. Consumer only.
+    void end_fd_wait();
+
+    /// @brief Selects how wait_and_pop_batch() waits. Call before the consumer starts.
+    void set_wait_policy(WaitPolicy policy, std::chrono::nanoseconds max_spin);
+
+private:
+    /// @brief One priority lane: a ring plus its "not full" condition.
+    struct Lane {
+        Lane(uint32_t capacity, MailboxType type, int numa_node);
+
+        bool try_push(Item& item);
+        uint32_t try_pop_batch(Item* out, uint32_t max_items);
+        uint32_t size() const;
+        uint32_t approx_size() const noexcept;
+        uint32_t capacity() const;
+
+        std::unique_ptr<ThreadSafeQueue<Item>> locked_queue;
+        std::unique_ptr<LockFreeQueue<Item>> lock_free_queue;
+
+        std::atomic<uint32_t> full_waiters{0}; // Blocked senders plus space_callbacks.
+        std::mutex space_mutex;
+        std::condition_variable space_cv;
+        std::vector<std::function<void()>> space_callbacks; // Guarded by space_mutex.
+    };
+
+    Lane& lane_for(MessagePriority priority) noexcept
+    {
+        return priority == MessagePriority::HIGH ? high_lane_ : normal_lane_;
+    }
+    Lane& lane_for(const Item& item) noexcept { return lane_for(item.priority); }
+
+    bool try_push(Lane& lane, Item& item);
+    void wake_consumer();
+    void notify_space(Lane& lane, uint32_t freed_slots);
+    void park_until_not_empty(std::chrono::steady_clock::time_point deadline);
+    bool spin_until_not_empty();
+    bool probably_empty() const noexcept;
+    void adapt_spin_budget(uint64_t gap_ns);
+
+    MailboxType type_;
+    Lane normal_lane_;
+    Lane high_lane_;
+    const uint32_t high_weight_;
+    uint32_t high_streak_ = 0; // Consumer only.
+
+    enum StopState : uint8_t { NOT_STOPPING, STOP_AFTER_DRAIN, STOP_NOW };
+
+    bool stop_due(uint8_t state) const;
+    static uint32_t pop_stop(Item* out);
+
+    std::atomic<uint8_t> stop_state_{NOT_STOPPING};
+    std::atomic<int64_t> drain_deadline_{INT64_MAX}; // steady_clock ticks; the earliest requested.
+    std::atomic<bool> closed_{false};
+
+    // Spinning before parking. Consumer only.
+    WaitPolicy wait_policy_ = WaitPolicy::PARK;
+    uint64_t max_spin_ns_ = 0;
+    uint64_t spin_budget_ns_ = 0;
+
+    // Consumer parking.
+    std::atomic<bool> consumer_parked_{false};
+    int wake_fd_ = -1; // eventfd used instead of park_cv_ when enabled.
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+};
+
+#endif // MAILBOX_HPP
@@ -0,0 +1,161 @@
+#include "ThreadWrapper/Placement.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+constexpr int MPOL_PREFERRED_MODE = 1; // <numaif.h> MPOL_PREFERRED, without a libnuma dependency.
+
+size_t page_round_up(size_t bytes)
+{
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) / page * page;
+}
+}
+
+bool parse_cpu_list(const std::string& text, std::vector<int>& cpus)
+{
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (end == range.c_str() || first < 0) {
+            return false;
+        }
+        if (*end == '-') {
+            const char* second = end + 1;
+            last = std::strtol(second, &end, 10);
+            if (end == second || last < first) {
+                return false;
+            }
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return true;
+}
+
+std::vector<int> numa_node_cpus(int node)
+{
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string text;
+    if (!file || !std::getline(file, text) || !parse_cpu_list(text, cpus)) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+int numa_node_of_cpu(int cpu)
+{
+    if (cpu < 0) {
+        return -1;
+    }
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (std::sscanf(entry->d_name, "node%d", &node) == 1) {
+            break;
+        }
+        node = -1;
+    }
+    closedir(dir);
+    return node;
+}
+
+int pin_current_thread(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return EINVAL;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+std::vector<int> current_thread_affinity()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+void current_cpu_and_node(int& cpu, int& node)
+{
+    unsigned int c = 0;
+    unsigned int n = 0;
+    if (syscall(SYS_getcpu, &c, &n, nullptr) == 0) {
+        cpu = static_cast<int>(c);
+        node = static_cast<int>(n);
+    } else {
+        cpu = -1;
+        node = -1;
+    }
+}
+
+void* numa_allocate(size_t bytes, int node)
+{
+    if (node < 0) {
+        return ::operator new(bytes);
+    }
+
+    size_t length = page_round_up(bytes);
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    // Preferred rather than strict binding: fall back to other nodes instead of failing.
+    unsigned long mask[4] = {0, 0, 0, 0};
+    const int bits_per_word = static_cast<int>(sizeof(unsigned long) * 8);
+    if (node < bits_per_word * 4) {
+        mask[node / bits_per_word] = 1UL << (node % bits_per_word);
+        syscall(SYS_mbind, ptr, length, MPOL_PREFERRED_MODE, mask, bits_per_word * 4, 0);
+    }
+    return ptr;
+}
+
+void numa_deallocate(void* ptr, size_t bytes, int node) noexcept
+{
+    if (!ptr) {
+        return;
+    }
+    if (node < 0) {
+        ::operator delete(ptr);
+        return;
+    }
+    munmap(ptr, page_round_up(bytes));
+}
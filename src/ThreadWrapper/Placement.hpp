@@ -0,0 +1,75 @@
+#ifndef PLACEMENT_HPP
+#define PLACEMENT_HPP
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @file Placement.hpp
+ * @brief CPU affinity and NUMA helpers (Linux). Everything degrades to a
+ * no-op returning "unknown" (-1 / empty) where the platform does not
+ * expose the information, e.g. inside restricted containers.
+ */
+
+/// @brief Parses a kernel cpu list such as "0-3,8,10-11". @return false on malformed input.
+bool parse_cpu_list(const std::string& text, std::vector<int>& cpus);
+
+/// @brief CPUs of a NUMA node, from sysfs. Empty if the node does not exist.
+std::vector<int> numa_node_cpus(int node);
+
+/// @brief NUMA node a CPU belongs to, from sysfs. -1 if unknown.
+int numa_node_of_cpu(int cpu);
+
+/// @brief Pins the calling thread to `cpus`. @return 0 or an errno value.
+int pin_current_thread(const std::vector<int>& cpus);
+
+/// @brief The calling thread's current affinity mask.
+std::vector<int> current_thread_affinity();
+
+/// @brief CPU and NUMA node the calling thread is running on right now (-1 if unknown).
+void current_cpu_and_node(int& cpu, int& node);
+
+/// @brief Allocates `bytes` of page-aligned memory preferring NUMA node `node` (< 0: plain operator new).
+void* numa_allocate(size_t bytes, int node);
+void numa_deallocate(void* ptr, size_t bytes, int node) noexcept;
+
+/**
+ * @brief Standard allocator placing its memory on one NUMA node.
+ * The policy is set before the pages are first touched, so it holds no matter
+ * which thread constructs the elements. Small allocations waste the rest of a page;
+ * use it for long-lived buffers such as mailbox rings.
+ */
+template<typename T>
+class NumaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit NumaAllocator(int node = -1) noexcept : node_(node) {}
+    template<typename U>
+    NumaAllocator(const NumaAllocator<U>& other) noexcept : node_(other.node()) {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(numa_allocate(n * sizeof(T), node_));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        numa_deallocate(ptr, n * sizeof(T), node_);
+    }
+
+    int node() const noexcept { return node_; }
+
+    template<typename U>
+    bool operator==(const NumaAllocator<U>& other) const noexcept { return node_ == other.node(); }
+    template<typename U>
+    bool operator!=(const NumaAllocator<U>& other) const noexcept { return node_ != other.node(); }
+
+private:
+    int node_;
+};
+
+#endif // PLACEMENT_HPP
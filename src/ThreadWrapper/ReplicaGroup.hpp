@@ -0,0 +1,64 @@
+#ifndef REPLICA_GROUP_HPP
+#define REPLICA_GROUP_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "ThreadWrapper/ThreadWrapperMgr.hpp"
+
+/**
+ * @class ReplicaGroup
+ * @brief The logical thread behind a replicated ThreadWrapperParam.
+ *
+ * A group has its own ID and name, but no thread or mailbox: every replica is
+ * an ordinary ThreadWrapperMgr registered as "<name>#<index>". Sends to the
+ * group's ID are dispatched to one replica per message. The replica list is
+ * fixed at creation; the managers are owned by the ThreadRegistry.
+ */
+class ReplicaGroup
+{
+public:
+    ReplicaGroup(std::vector<ThreadWrapperMgr*> replicas, ReplicaDispatch dispatch)
+        : replicas_(std::move(replicas)), dispatch_(dispatch) {}
+
+    ReplicaGroup(const ReplicaGroup&) = delete;
+    ReplicaGroup& operator=(const ReplicaGroup&) = delete;
+
+    /// @brief Chooses the replica for the next message. Safe from any thread.
+    ThreadWrapperMgr* pick() noexcept
+    {
+        uint32_t start = next_.fetch_add(1, std::memory_order_relaxed);
+        size_t count = replicas_.size();
+        if (dispatch_ == ReplicaDispatch::ROUND_ROBIN) {
+            return replicas_[start % count];
+        }
+
+        // Least loaded; scanning from a rotating start spreads ties. Sizes are
+        // read without locks, since this runs on every send to the group.
+        ThreadWrapperMgr* best = nullptr;
+        uint32_t best_size = UINT32_MAX;
+        for (size_t i = 0; i < count; ++i) {
+            ThreadWrapperMgr* mgr = replicas_[(start + i) % count];
+            uint32_t size = mgr->approx_queue_size();
+            if (size < best_size) {
+                best = mgr;
+                best_size = size;
+                if (size == 0) {
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    const std::vector<ThreadWrapperMgr*>& replicas() const noexcept { return replicas_; }
+    ReplicaDispatch dispatch() const noexcept { return dispatch_; }
+
+private:
+    const std::vector<ThreadWrapperMgr*> replicas_;
+    const ReplicaDispatch dispatch_;
+    std::atomic<uint32_t> next_{0};
+};
+
+#endif // REPLICA_GROUP_HPP
@@ -0,0 +1,136 @@
+#include "ThreadWrapper/RequestReply.hpp"
+
+#include <utility>
+
+void PendingReplies::State::set(Reply value)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reply = std::move(value);
+        done = true;
+    }
+    cv.notify_all();
+}
+
+uint32_t PendingReplies::add(std::shared_ptr<State> state)
+{
+    Entry entry;
+    entry.state = std::move(state);
+    return add(std::move(entry));
+}
+
+uint32_t PendingReplies::add(ReplyCallback callback)
+{
+    Entry entry;
+    entry.callback = std::move(callback);
+    return add(std::move(entry));
+}
+
+uint32_t PendingReplies::add(Entry entry)
+{
+    while (true) {
+        uint32_t id = last_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (id == 0) {
+            continue;
+        }
+        Shard& shard = shard_for(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // After a wrap-around, skip IDs whose request is still outstanding.
+        if (shard.entries.emplace(id, std::move(entry)).second) {
+            return id;
+        }
+    }
+}
+
+bool PendingReplies::complete(uint32_t id, Reply reply)
+{
+    Entry entry;
+    {
+        Shard& shard = shard_for(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(id);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        entry = std::move(it->second);
+        shard.entries.erase(it);
+    }
+
+    if (entry.state) {
+        entry.state->set(std::move(reply));
+    } else {
+        entry.callback(std::move(reply));
+    }
+    return true;
+}
+
+bool PendingReplies::cancel(uint32_t id)
+{
+    Shard& shard = shard_for(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.entries.erase(id) != 0;
+}
+
+ReplyFuture& ReplyFuture::operator=(ReplyFuture&& other) noexcept
+{
+    if (this != &other) {
+        abandon();
+        pending_ = other.pending_;
+        id_ = other.id_;
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+bool ReplyFuture::ready() const
+{
+    if (!state_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->done;
+}
+
+Reply ReplyFuture::get()
+{
+    if (!state_) {
+        Reply reply;
+        reply.error = ThreadWrapperError::ERROR;
+        return reply;
+    }
+    std::shared_ptr<PendingReplies::State> state = std::move(state_);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state]() { return state->done; });
+    return std::move(state->reply);
+}
+
+Reply ReplyFuture::get_for(std::chrono::steady_clock::duration timeout)
+{
+    if (!state_) {
+        Reply reply;
+        reply.error = ThreadWrapperError::ERROR;
+        return reply;
+    }
+    std::shared_ptr<PendingReplies::State> state = std::move(state_);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (!state->cv.wait_for(lock, timeout, [&state]() { return state->done; })) {
+        lock.unlock();
+        if (pending_->cancel(id_)) {
+            Reply reply;
+            reply.error = ThreadWrapperError::TIMEOUT;
+            return reply;
+        }
+        // The reply was being delivered just now; it is moments away.
+        lock.lock();
+        state->cv.wait(lock, [&state]() { return state->done; });
+    }
+    return std::move(state->reply);
+}
+
+void ReplyFuture::abandon()
+{
+    if (state_ && !ready()) {
+        pending_->cancel(id_);
+    }
+    state_.reset();
+}
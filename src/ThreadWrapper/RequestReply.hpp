@@ -0,0 +1,129 @@
+#ifndef REQUEST_REPLY_HPP
+#define REQUEST_REPLY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "ThreadWrapper/ThreadWrapper.hpp"
+#include "ThreadWrapper/ThreadWrapperMessage.hpp"
+
+/**
+ * @struct Reply
+ * @brief The answer to a request: the REPLY envelope, or why there is none.
+ */
+struct Reply {
+    ThreadWrapperError error = ThreadWrapperError::OK; // TIMEOUT, or why the request could not be sent.
+    ThreadWrapperMessage message;                      // The REPLY envelope when error is OK.
+
+    bool ok() const noexcept { return error == ThreadWrapperError::OK; }
+
+    template<typename T>
+    T* payload_as() { return message.payload_as<T>(); }
+};
+
+/// @brief Receives the reply to a ThreadWrapperApp::send_request(), on the replying thread.
+using ReplyCallback = std::function<void(Reply)>;
+
+/**
+ * @class PendingReplies
+ * @brief Requests sent with ThreadWrapperApp::send_request() that still wait
+ * for their reply, by correlation ID.
+ *
+ * Sharded by ID, so concurrent requesters and repliers rarely meet on a lock;
+ * the waiter is completed outside the shard lock.
+ */
+class PendingReplies
+{
+public:
+    /// @brief Where a ReplyFuture waits for its reply.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        Reply reply;
+
+        void set(Reply value);
+    };
+
+    /// @brief Registers a waiter. @return Its correlation ID (never 0).
+    uint32_t add(std::shared_ptr<State> state);
+    uint32_t add(ReplyCallback callback);
+
+    /// @brief Delivers the reply and forgets the request. @return false if nobody waits for `id` any more.
+    bool complete(uint32_t id, Reply reply);
+
+    /// @brief Forgets a request; a later reply is dropped. @return false if it was completed already.
+    bool cancel(uint32_t id);
+
+private:
+    struct Entry {
+        std::shared_ptr<State> state;
+        ReplyCallback callback;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, Entry> entries;
+    };
+
+    static constexpr uint32_t SHARDS = 16;
+
+    uint32_t add(Entry entry);
+    Shard& shard_for(uint32_t id) noexcept { return shards_[id % SHARDS]; }
+
+    std::atomic<uint32_t> last_id_{0};
+    Shard shards_[SHARDS];
+};
+
+/**
+ * @class ReplyFuture
+ * @brief The reply to one ThreadWrapperApp::send_request(), like a std::future.
+ *
+ * Destroying a future that has not been read cancels the request, so a reply
+ * that still arrives is dropped instead of being kept forever.
+ */
+class ReplyFuture
+{
+public:
+    ReplyFuture() = default;
+    ReplyFuture(PendingReplies* pending, uint32_t id, std::shared_ptr<PendingReplies::State> state)
+        : pending_(pending), id_(id), state_(std::move(state)) {}
+    ~ReplyFuture() { abandon(); }
+
+    ReplyFuture(ReplyFuture&& other) noexcept
+        : pending_(other.pending_), id_(other.id_), state_(std::move(other.state_)) {}
+    ReplyFuture& operator=(ReplyFuture&& other) noexcept;
+
+    ReplyFuture(const ReplyFuture&) = delete;
+    ReplyFuture& operator=(const ReplyFuture&) = delete;
+
+    /// @brief False after get() or for a default-constructed future.
+    bool valid() const noexcept { return state_ != nullptr; }
+
+    /// @brief True once get() would not block.
+    bool ready() const;
+
+    /// @brief Blocks until the reply arrives. The future is invalid afterwards.
+    Reply get();
+
+    /**
+     * @brief Waits at most `timeout`. On expiry the request is cancelled and the
+     * result's error is TIMEOUT. The future is invalid afterwards.
+     */
+    Reply get_for(std::chrono::steady_clock::duration timeout);
+
+private:
+    void abandon();
+
+    PendingReplies* pending_ = nullptr;
+    uint32_t id_ = 0;
+    std::shared_ptr<PendingReplies::State> state_;
+};
+
+#endif // REQUEST_REPLY_HPP
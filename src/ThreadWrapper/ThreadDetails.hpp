@@ -5,6 +5,7 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
+#include "ThreadWrapper/ThreadMetrics.hpp"
 #include "ThreadWrapper/ThreadWrapperMgr.hpp" // For ThreadWrapperStatus enum
 
 // Helper function to convert status enum to a readable string
@@ -25,6 +26,17 @@ struct ThreadDetails {
     ThreadWrapperStatus status = ThreadWrapperStatus::ERROR;
     uint32_t queue_size = 0;
     int reference_count = 0;
+    // Placement: where the thread last ran, its actual affinity mask and the
+    // NUMA node its mailbox lives on. -1 / empty when unknown.
+    int cpu = -1;
+    int numa_node = -1;
+    std::vector<int> cpu_affinity;
+    int memory_node = -1;
+    // Hot-path counters and latency histograms since the thread started.
+    ThreadMetricsSnapshot metrics;
+    // For a replicated thread: one entry per replica. The fields above are then
+    // aggregated (queue_size and metrics are summed, status is RUNNING only if all replicas are).
+    std::vector<ThreadDetails> replicas;
 };
 
 struct TaskDetails {
@@ -0,0 +1,100 @@
+#include "ThreadWrapper/ThreadMetrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+uint64_t HistogramSnapshot::percentile(double quantile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    quantile = std::min(std::max(quantile, 0.0), 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::bucket_upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other)
+{
+    if (buckets.size() < other.buckets.size()) {
+        buckets.resize(other.buckets.size(), 0);
+    }
+    for (size_t i = 0; i < other.buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    max = std::max(max, other.max);
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t value_ns) noexcept
+{
+    if (value_ns < SUB_BUCKETS) {
+        return static_cast<size_t>(value_ns);
+    }
+    uint32_t exponent = 63u - static_cast<uint32_t>(__builtin_clzll(value_ns));
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    uint32_t shift = exponent - SUB_BUCKET_BITS;
+    size_t sub_bucket = static_cast<size_t>((value_ns >> shift) & (SUB_BUCKETS - 1));
+    return SUB_BUCKETS + static_cast<size_t>(shift) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t bucket) noexcept
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    if (bucket >= BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    uint32_t shift = static_cast<uint32_t>((bucket - SUB_BUCKETS) / SUB_BUCKETS);
+    uint64_t sub_bucket = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const
+{
+    HistogramSnapshot snapshot;
+    snapshot.buckets.resize(BUCKETS);
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.max = max_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void ThreadMetricsSnapshot::merge(const ThreadMetricsSnapshot& other)
+{
+    messages_processed += other.messages_processed;
+    batches += other.batches;
+    enqueue_failures += other.enqueue_failures;
+    peak_queue_depth = std::max(peak_queue_depth, other.peak_queue_depth);
+    busy_ns += other.busy_ns;
+    blocked_ns += other.blocked_ns;
+    batch_time.merge(other.batch_time);
+    process_time.merge(other.process_time);
+    queue_wait.merge(other.queue_wait);
+}
+
+ThreadMetricsSnapshot ThreadMetrics::snapshot() const
+{
+    ThreadMetricsSnapshot snapshot;
+    snapshot.messages_processed = messages_processed_.load(std::memory_order_relaxed);
+    snapshot.batches = batches_.load(std::memory_order_relaxed);
+    snapshot.enqueue_failures = enqueue_failures_.load(std::memory_order_relaxed);
+    snapshot.peak_queue_depth = peak_queue_depth_.load(std::memory_order_relaxed);
+    snapshot.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+    snapshot.blocked_ns = blocked_ns_.load(std::memory_order_relaxed);
+    snapshot.batch_time = batch_time_.snapshot();
+    snapshot.process_time = process_time_.snapshot();
+    snapshot.queue_wait = queue_wait_.snapshot();
+    return snapshot;
+}
@@ -0,0 +1,182 @@
+#ifndef THREAD_METRICS_HPP
+#define THREAD_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct HistogramSnapshot
+ * @brief A copy of a LatencyHistogram's buckets, for reporting and merging.
+ */
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t max = 0;
+
+    /// @brief Value at or below which `quantile` (0..1) of the samples fall. 0 if empty.
+    uint64_t percentile(double quantile) const;
+    /// @brief Adds another histogram's samples (e.g. to aggregate replicas).
+    void merge(const HistogramSnapshot& other);
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style histogram of nanosecond durations with ~12.5% relative precision.
+ *
+ * Buckets are powers of two split into 8 linear sub-buckets, from 1 ns up to
+ * about 18 minutes (larger values land in the last bucket). There is a
+ * single writer at a time: record() is a relaxed load and store per bucket,
+ * no read-modify-write, so it costs a few nanoseconds. Readers on other
+ * threads may see a snapshot that is slightly behind.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_EXPONENT = 40;
+    static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    /// @brief Records `samples` occurrences of `value_ns`. Single writer.
+    void record(uint64_t value_ns, uint64_t samples = 1) noexcept
+    {
+        auto& bucket = buckets_[bucket_of(value_ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + samples, std::memory_order_relaxed);
+        if (value_ns > max_.load(std::memory_order_relaxed)) {
+            max_.store(value_ns, std::memory_order_relaxed);
+        }
+    }
+
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucket_of(uint64_t value_ns) noexcept;
+    /// @brief Largest value that falls into `bucket`.
+    static uint64_t bucket_upper_bound(size_t bucket) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @struct ThreadMetricsSnapshot
+ * @brief Point-in-time copy of a wrapper's metrics, as reported in ThreadDetails.
+ */
+struct ThreadMetricsSnapshot {
+    uint64_t messages_processed = 0;
+    uint64_t batches = 0;
+    uint64_t enqueue_failures = 0;   // Sends rejected because the mailbox was full (or timed out).
+    uint64_t peak_queue_depth = 0;   // Deepest backlog seen when dequeuing.
+    uint64_t busy_ns = 0;            // Time spent in process_batch().
+    uint64_t blocked_ns = 0;         // Time spent waiting for messages (dedicated threads only).
+    HistogramSnapshot batch_time;    // One sample per process_batch() call, for the whole batch.
+    HistogramSnapshot process_time;  // One handler call, for a sample of the messages.
+    HistogramSnapshot queue_wait;    // Enqueue to dequeue, for a sample of the messages.
+
+    /// @brief busy / (busy + blocked); 0 before the wrapper has run.
+    double busy_ratio() const
+    {
+        uint64_t total = busy_ns + blocked_ns;
+        return total == 0 ? 0.0 : static_cast<double>(busy_ns) / static_cast<double>(total);
+    }
+
+    /// @brief Adds another wrapper's metrics (e.g. to aggregate replicas).
+    void merge(const ThreadMetricsSnapshot& other);
+};
+
+/**
+ * @class ThreadMetrics
+ * @brief Live hot-path counters owned by a ThreadWrapperMgr.
+ *
+ * Everything except enqueue_failures is written only by the wrapper's
+ * consumer, once per batch, with relaxed atomics so that details queries
+ * from other threads are race-free. Enqueue failures come from any sender,
+ * but only on the failure path.
+ */
+class ThreadMetrics
+{
+public:
+    /// @brief Enqueue timestamps are taken on one in this many sends per sending thread.
+    static constexpr uint32_t QUEUE_WAIT_SAMPLE_PERIOD = 64;
+
+    /// @brief Monotonic time in nanoseconds.
+    static uint64_t now_ns() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Enqueue stamps fit the envelope's spare 32 bits: monotonic time in
+     * 64 ns units, wrapping every ~4.5 minutes. 0 means "not sampled".
+     */
+    static uint32_t make_stamp(uint64_t now_ns) noexcept
+    {
+        uint32_t stamp = static_cast<uint32_t>(now_ns >> STAMP_SHIFT);
+        return stamp != 0 ? stamp : 1;
+    }
+
+    static uint64_t stamp_age_ns(uint32_t stamp, uint64_t now_ns) noexcept
+    {
+        return static_cast<uint64_t>(static_cast<uint32_t>(make_stamp(now_ns) - stamp)) << STAMP_SHIFT;
+    }
+
+    void add_enqueue_failure() noexcept { enqueue_failures_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief Consumer only: records one processed batch and how long it took.
+    void record_batch(uint32_t messages, uint64_t busy_ns) noexcept
+    {
+        add(messages_processed_, messages);
+        add(batches_, 1);
+        add(busy_ns_, busy_ns);
+        batch_time_.record(busy_ns);
+    }
+
+    /// @brief Consumer only: counts a message handed out by receive_message(), which is not timed.
+    void record_received() noexcept
+    {
+        add(messages_processed_, 1);
+        add(batches_, 1);
+    }
+
+    void record_blocked(uint64_t blocked_ns) noexcept { add(blocked_ns_, blocked_ns); }
+    void record_process_time(uint64_t process_ns) noexcept { process_time_.record(process_ns); }
+    void record_queue_wait(uint64_t wait_ns) noexcept { queue_wait_.record(wait_ns); }
+
+    void record_queue_depth(uint64_t depth) noexcept
+    {
+        if (depth > peak_queue_depth_.load(std::memory_order_relaxed)) {
+            peak_queue_depth_.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t messages_processed() const noexcept { return messages_processed_.load(std::memory_order_relaxed); }
+
+    ThreadMetricsSnapshot snapshot() const;
+
+private:
+    static constexpr uint32_t STAMP_SHIFT = 6;
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t value) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> messages_processed_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> peak_queue_depth_{0};
+    std::atomic<uint64_t> busy_ns_{0};
+    std::atomic<uint64_t> blocked_ns_{0};
+    LatencyHistogram batch_time_;
+    LatencyHistogram process_time_;
+    LatencyHistogram queue_wait_;
+
+    // Written by senders; kept off the consumer's cache lines.
+    alignas(64) std::atomic<uint64_t> enqueue_failures_{0};
+};
+
+#endif // THREAD_METRICS_HPP
@@ -0,0 +1,166 @@
+#include "ThreadWrapper/ThreadRegistry.hpp"
+#include <thread>
+
+ThreadRegistry::ReadGuard::ReadGuard(const ThreadRegistry& registry)
+    : registry_(registry),
+      stripe_(reader_stripe())
+{
+    // Register in the current epoch, then re-check it: if a writer flipped the
+    // epoch in between, it may already have scanned our counter, so retry.
+    while (true) {
+        epoch_ = registry_.epoch_.load(std::memory_order_seq_cst) & 1;
+        registry_.readers_[epoch_][stripe_].value.fetch_add(1, std::memory_order_seq_cst);
+        if ((registry_.epoch_.load(std::memory_order_seq_cst) & 1) == epoch_) {
+            break;
+        }
+        registry_.readers_[epoch_][stripe_].value.fetch_sub(1, std::memory_order_release);
+    }
+    table_ = registry_.current_.load(std::memory_order_seq_cst);
+}
+
+ThreadRegistry::ReadGuard::~ReadGuard()
+{
+    registry_.readers_[epoch_][stripe_].value.fetch_sub(1, std::memory_order_release);
+}
+
+ThreadRegistry::ThreadRegistry()
+    : current_owner_(std::make_unique<Table>())
+{
+    current_.store(current_owner_.get(), std::memory_order_release);
+}
+
+ThreadRegistry::~ThreadRegistry()
+{
+    remove(ids());
+}
+
+int ThreadRegistry::next_id() const noexcept
+{
+    if (!free_slots_.empty()) {
+        uint32_t slot = free_slots_.back();
+        return make_id(slot, owned_[slot].generation);
+    }
+    if (owned_.size() >= MAX_SLOTS) {
+        return INVALID_INSTANCE_ID;
+    }
+    return make_id(static_cast<uint32_t>(owned_.size()), 0);
+}
+
+int ThreadRegistry::add(std::unique_ptr<ThreadWrapperMgr> mgr)
+{
+    return insert(std::move(mgr), nullptr);
+}
+
+int ThreadRegistry::add_group(std::unique_ptr<ReplicaGroup> group)
+{
+    return insert(nullptr, std::move(group));
+}
+
+int ThreadRegistry::insert(std::unique_ptr<ThreadWrapperMgr> mgr, std::unique_ptr<ReplicaGroup> group)
+{
+    const int id = next_id();
+    if (id == INVALID_INSTANCE_ID) {
+        return INVALID_INSTANCE_ID;
+    }
+    const uint32_t slot = slot_of(id);
+    auto next = std::make_unique<Table>(*current_owner_);
+    if (slot == owned_.size()) {
+        next->slots.push_back(Slot{mgr.get(), group.get(), 0});
+        owned_.push_back(Entry{std::move(mgr), std::move(group), 0});
+    } else {
+        free_slots_.pop_back();
+        next->slots[slot] = Slot{mgr.get(), group.get(), owned_[slot].generation};
+        owned_[slot].mgr = std::move(mgr);
+        owned_[slot].group = std::move(group);
+    }
+    publish(std::move(next));
+    return id;
+}
+
+void ThreadRegistry::remove(const std::vector<int>& ids)
+{
+    std::vector<uint32_t> slots;
+    auto next = std::make_unique<Table>(*current_owner_);
+    for (int id : ids) {
+        if (!is_live(id)) {
+            continue;
+        }
+        const uint32_t slot = slot_of(id);
+        owned_[slot].generation = (owned_[slot].generation + 1) % GENERATION_LIMIT;
+        next->slots[slot] = Slot{nullptr, nullptr, owned_[slot].generation};
+        slots.push_back(slot);
+    }
+    if (slots.empty()) {
+        return;
+    }
+    publish(std::move(next));
+
+    // No new reader can reach the removed managers now; wait out the senders
+    // that pinned one before it was unpublished.
+    for (uint32_t slot : slots) {
+        while (owned_[slot].mgr && owned_[slot].mgr->is_pinned()) {
+            std::this_thread::yield();
+        }
+    }
+    // Groups first: they point at replicas that may be removed alongside.
+    for (uint32_t slot : slots) {
+        owned_[slot].group.reset();
+    }
+    for (uint32_t slot : slots) {
+        owned_[slot].mgr.reset();
+        free_slots_.push_back(slot);
+    }
+}
+
+std::vector<int> ThreadRegistry::ids() const
+{
+    std::vector<int> result;
+    for (uint32_t slot = 0; slot < owned_.size(); ++slot) {
+        if (owned_[slot].mgr || owned_[slot].group) {
+            result.push_back(make_id(slot, owned_[slot].generation));
+        }
+    }
+    return result;
+}
+
+bool ThreadRegistry::is_live(int id) const noexcept
+{
+    const uint32_t slot = slot_of(id);
+    return id >= 0 && slot < owned_.size() && owned_[slot].generation == generation_of(id) &&
+           (owned_[slot].mgr || owned_[slot].group);
+}
+
+ThreadWrapperMgr* ThreadRegistry::at(int id) const noexcept
+{
+    return is_live(id) ? owned_[slot_of(id)].mgr.get() : nullptr;
+}
+
+ReplicaGroup* ThreadRegistry::group_at(int id) const noexcept
+{
+    return is_live(id) ? owned_[slot_of(id)].group.get() : nullptr;
+}
+
+void ThreadRegistry::publish(std::unique_ptr<Table> next)
+{
+    current_.store(next.get(), std::memory_order_seq_cst);
+    synchronize();
+    current_owner_ = std::move(next); // Frees the old table; no reader holds it any more.
+}
+
+void ThreadRegistry::synchronize() const
+{
+    uint32_t old_epoch = epoch_.load(std::memory_order_relaxed) & 1;
+    epoch_.store(old_epoch ^ 1, std::memory_order_seq_cst);
+    for (uint32_t i = 0; i < READER_STRIPES; ++i) {
+        while (readers_[old_epoch][i].value.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t ThreadRegistry::reader_stripe() noexcept
+{
+    static std::atomic<uint32_t> next_stripe{0};
+    thread_local uint32_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % READER_STRIPES;
+    return stripe;
+}
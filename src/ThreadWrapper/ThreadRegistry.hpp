@@ -0,0 +1,158 @@
+#ifndef THREAD_REGISTRY_HPP
+#define THREAD_REGISTRY_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ThreadWrapper/LockFreeQueue.hpp" // CACHE_LINE_SIZE
+#include "ThreadWrapper/ReplicaGroup.hpp"
+#include "ThreadWrapper/ThreadWrapperMgr.hpp"
+
+/**
+ * @class ThreadRegistry
+ * @brief ID -> ThreadWrapperMgr table with lock-free, read-mostly lookups.
+ *
+ * An ID names either a single manager or a ReplicaGroup, whose replicas
+ * have IDs of their own. Its low 16 bits are a slot in the table and the
+ * bits above are the slot's generation, which is bumped each time the slot
+ * is emptied. remove() frees slots for reuse, so the table stays as large as
+ * the most threads alive at once, however many come and go; an ID kept past
+ * its thread's removal fails the generation check instead of reaching
+ * whichever thread took the slot next. A slot's generation wraps after
+ * 32768 reuses, keeping IDs positive.
+ *
+ * The table is immutable once published. Writers copy it, modify the copy,
+ * publish it with an atomic pointer swap and then wait for a grace period
+ * before freeing the old table (RCU style). Readers never lock: a ReadGuard
+ * bumps one of a set of striped counters for the current epoch, and a
+ * writer's grace period flips the epoch and waits for the old epoch's
+ * counters to drain.
+ *
+ * A ReadGuard must only be held for a short, non-blocking section. Code that
+ * needs a manager across a blocking call pins it (ThreadWrapperMgr::pin())
+ * inside the guard and unpins it afterwards; removal waits for those pins.
+ *
+ * Writer methods (next_id, add, add_group, remove, ids, at, group_at) must
+ * be serialized by the caller.
+ */
+class ThreadRegistry
+{
+private:
+    struct Slot {
+        ThreadWrapperMgr* mgr = nullptr;
+        ReplicaGroup* group = nullptr;
+        uint32_t generation = 0;
+    };
+
+    struct Table {
+        std::vector<Slot> slots;
+    };
+
+public:
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const ThreadRegistry& registry);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        /**
+         * @brief Returns the manager that should receive a message for `id`, or nullptr.
+         * For a replica group this picks one replica. Valid until the guard is released.
+         */
+        ThreadWrapperMgr* resolve(int id) const noexcept
+        {
+            const uint32_t index = slot_of(id);
+            if (id < 0 || index >= table_->slots.size()) {
+                return nullptr;
+            }
+            const Slot& slot = table_->slots[index];
+            if (slot.generation != generation_of(id)) {
+                return nullptr; // The thread this ID named is gone.
+            }
+            return slot.group ? slot.group->pick() : slot.mgr;
+        }
+
+    private:
+        const ThreadRegistry& registry_;
+        const Table* table_;
+        uint32_t epoch_;
+        uint32_t stripe_;
+    };
+
+    ThreadRegistry();
+    ~ThreadRegistry();
+
+    ThreadRegistry(const ThreadRegistry&) = delete;
+    ThreadRegistry& operator=(const ThreadRegistry&) = delete;
+
+    static constexpr uint32_t SLOT_BITS = 16;
+    static constexpr uint32_t MAX_SLOTS = 1u << SLOT_BITS;
+
+    /// @brief The ID the next add() or add_group() will return; INVALID_INSTANCE_ID if the table is full.
+    int next_id() const noexcept;
+
+    /// @brief Registers a manager in a free slot and publishes it. @return its ID, or INVALID_INSTANCE_ID if full.
+    int add(std::unique_ptr<ThreadWrapperMgr> mgr);
+
+    /// @brief Registers a replica group (its replicas must already be registered). @return its ID.
+    int add_group(std::unique_ptr<ReplicaGroup> group);
+
+    /**
+     * @brief Unpublishes and destroys the given managers and groups, and frees
+     * their slots. Stale IDs are skipped. Returns once no reader can still see
+     * them and no sender has them pinned.
+     */
+    void remove(const std::vector<int>& ids);
+
+    /// @brief IDs of every registered manager and group, in slot order.
+    std::vector<int> ids() const;
+
+    /// @brief Writer-side lookup (caller holds the writer lock). nullptr if stale or a group.
+    ThreadWrapperMgr* at(int id) const noexcept;
+    /// @brief Writer-side lookup of a replica group. nullptr if stale or a single manager.
+    ReplicaGroup* group_at(int id) const noexcept;
+
+private:
+    static constexpr uint32_t GENERATION_LIMIT = 1u << (31 - SLOT_BITS);
+
+    static uint32_t slot_of(int id) noexcept { return static_cast<uint32_t>(id) & (MAX_SLOTS - 1); }
+    static uint32_t generation_of(int id) noexcept { return static_cast<uint32_t>(id) >> SLOT_BITS; }
+    static int make_id(uint32_t slot, uint32_t generation) noexcept
+    {
+        return static_cast<int>((generation << SLOT_BITS) | slot);
+    }
+
+    int insert(std::unique_ptr<ThreadWrapperMgr> mgr, std::unique_ptr<ReplicaGroup> group);
+    bool is_live(int id) const noexcept;
+    void publish(std::unique_ptr<Table> next);
+    void synchronize() const;
+    static uint32_t reader_stripe() noexcept;
+
+    static constexpr uint32_t READER_STRIPES = 32;
+
+    struct alignas(CACHE_LINE_SIZE) ReaderCounter {
+        std::atomic<int64_t> value{0};
+    };
+
+    mutable ReaderCounter readers_[2][READER_STRIPES];
+    mutable std::atomic<uint32_t> epoch_{0};
+    std::atomic<const Table*> current_{nullptr};
+
+    // Writer side only.
+    struct Entry {
+        std::unique_ptr<ThreadWrapperMgr> mgr;
+        std::unique_ptr<ReplicaGroup> group;
+        uint32_t generation = 0;
+    };
+
+    std::unique_ptr<Table> current_owner_;
+    std::vector<Entry> owned_;
+    std::vector<uint32_t> free_slots_; // Reused last-freed first.
+};
+
+#endif // THREAD_REGISTRY_HPP
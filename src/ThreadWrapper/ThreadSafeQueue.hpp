@@ -1,9 +1,12 @@
 #ifndef THREAD_SAFE_QUEUE_HPP
 #define THREAD_SAFE_QUEUE_HPP
 
-#include <queue>
+#include <atomic>
+#include <vector>
+#include <cstdint>
 #include <mutex>
 #include <condition_variable>
+#include "ThreadWrapper/Placement.hpp"
 
 template<typename T>
 class ThreadSafeQueue {
@@ -11,20 +14,18 @@ public:
     /**
      * @brief Constructor with a specific capacity.
      * @param capacity The maximum number of items the queue can hold.
+     * @param numa_node NUMA node to place the storage on; -1 for the default allocator.
      */
-    explicit ThreadSafeQueue(uint32_t capacity)
+    explicit ThreadSafeQueue(uint32_t capacity, int numa_node = -1)
+        : queue_capacity_(clamp_capacity(capacity)),
+          queue_(queue_capacity_, numa_node)
     {
-        if (capacity >= MIN_QUEUE_CAPACITY && capacity <= MAX_QUEUE_CAPACITY) {
-            queue_capacity_ = capacity;
-        } else {
-            queue_capacity_ = DEFAULT_QUEUE_CAPACITY;
-        }
     }
 
     /**
      * @brief Default constructor with default capacity.
      */
-    ThreadSafeQueue() : queue_capacity_(DEFAULT_QUEUE_CAPACITY) {}
+    ThreadSafeQueue() : ThreadSafeQueue(DEFAULT_QUEUE_CAPACITY) {}
 
     ~ThreadSafeQueue() = default;
 
@@ -32,21 +33,36 @@ public:
     ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
 
     /**
-     * @brief Pushes a value onto the queue if there is capacity.
+     * @brief Pushes a value onto the queue if there is capacity, and wakes one
+     * consumer blocked in wait_and_pop() or wait_and_pop_batch().
      * @param value The value to push.
      * @return true on success, false if the queue is full.
      */
     bool push(T value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (queue_.size() >= queue_capacity_) {
-            return false; // Queue is full
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!push_locked(value)) {
+                return false;
+            }
         }
-        queue_.push(std::move(value));
-        cond_var_.notify_one(); // Notify one waiting consumer
+        cond_var_.notify_one();
         return true;
     }
 
+    /**
+     * @brief Like push(), but only moves from `value` if the push succeeds, and
+     * does not wake blocked consumers. For owners that park their consumer on
+     * their own signal (as Mailbox does) and never call the wait_and_pop* API.
+     * @param value The value to push; left intact if the queue is full.
+     * @return true on success, false if the queue is full.
+     */
+    bool try_push(T& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return push_locked(value);
+    }
+
     /**
      * @brief Tries to pop a value from the queue without blocking.
      * @param[out] value Reference to store the popped value.
@@ -75,6 +91,30 @@ public:
         queue_.pop();
     }
 
+    /**
+     * @brief Pops up to `max_items` values in a single lock hold, without blocking.
+     * @param[out] out Array with room for at least `max_items` values.
+     * @return The number of values popped (0 if the queue was empty).
+     */
+    uint32_t try_pop_batch(T* out, uint32_t max_items)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pop_batch_locked(out, max_items);
+    }
+
+    /**
+     * @brief Waits until at least one item is available, then pops up to
+     * `max_items` values in the same lock hold.
+     * @param[out] out Array with room for at least `max_items` values.
+     * @return The number of values popped (at least 1 if max_items > 0).
+     */
+    uint32_t wait_and_pop_batch(T* out, uint32_t max_items)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_var_.wait(lock, [this] { return !queue_.empty(); });
+        return pop_batch_locked(out, max_items);
+    }
+
     /// @brief Checks if the queue is empty.
     bool empty() const
     {
@@ -89,9 +129,78 @@ public:
         return queue_.size();
     }
 
+    /**
+     * @brief Number of items without taking the lock, for polling loops. It may
+     * lag a concurrent push or pop; confirm with a real pop.
+     */
+    uint32_t approx_size() const noexcept { return static_cast<uint32_t>(queue_.size()); }
+
+    uint32_t capacity() const noexcept { return queue_capacity_; }
+
 private:
-    std::queue<T> queue_;
+    /**
+     * @brief Fixed-size ring with the subset of the std::queue interface used above.
+     * Storage is allocated once, so steady-state push/pop never touches the allocator.
+     * The count is only written under the queue's lock, but is atomic so that
+     * approx_size() can read it without one.
+     */
+    class Ring {
+    public:
+        Ring(uint32_t capacity, int numa_node) : slots_(capacity, NumaAllocator<T>(numa_node)) {}
+
+        bool empty() const noexcept { return size() == 0; }
+        size_t size() const noexcept { return count_.load(std::memory_order_relaxed); }
+        T& front() { return slots_[head_]; }
+
+        void push(T&& value)
+        {
+            const size_t count = size();
+            slots_[(head_ + count) % slots_.size()] = std::move(value);
+            count_.store(count + 1, std::memory_order_relaxed);
+        }
+
+        void pop()
+        {
+            slots_[head_] = T();
+            head_ = (head_ + 1) % slots_.size();
+            count_.store(size() - 1, std::memory_order_relaxed);
+        }
+
+    private:
+        std::vector<T, NumaAllocator<T>> slots_;
+        size_t head_ = 0;
+        std::atomic<size_t> count_{0};
+    };
+
+    static uint32_t clamp_capacity(uint32_t capacity)
+    {
+        if (capacity >= MIN_QUEUE_CAPACITY && capacity <= MAX_QUEUE_CAPACITY) {
+            return capacity;
+        }
+        return DEFAULT_QUEUE_CAPACITY;
+    }
+
+    bool push_locked(T& value)
+    {
+        if (queue_.size() >= queue_capacity_) {
+            return false; // Queue is full
+        }
+        queue_.push(std::move(value));
+        return true;
+    }
+
+    uint32_t pop_batch_locked(T* out, uint32_t max_items)
+    {
+        uint32_t count = 0;
+        while (count < max_items && !queue_.empty()) {
+            out[count++] = std::move(queue_.front());
+            queue_.pop();
+        }
+        return count;
+    }
+
     uint32_t queue_capacity_;
+    Ring queue_;
     mutable std::mutex mutex_;
     std::condition_variable cond_var_;
 
@@ -1,4 +1,7 @@
 #include "ThreadWrapper/ThreadWrapper.hpp"
+#include "ThreadWrapper/ThreadWrapperApp.hpp"
+
+#include <cstdio>
 
 // OPTIMIZED: Renamed from base_config to configure.
 ThreadWrapperError ThreadWrapper::configure(int instance_id, const std::string& thread_name, int device_id)
@@ -13,4 +16,118 @@ ThreadWrapperError ThreadWrapper::configure(int instance_id, const std::string&
     configured_ = true;
 
     return ThreadWrapperError::OK;
-}
\ No newline at end of file
+}
+void ThreadWrapper::declare_outputs(const std::vector<ThreadOutput>& outputs)
+{
+    outputs_.clear();
+    for (const auto& output : outputs)
+    {
+        outputs_.push_back(OutputPort{output.name, output.targets, {}});
+    }
+}
+
+ThreadWrapperError ThreadWrapper::bind_outputs(const std::function<int(const std::string&)>& resolve_id)
+{
+    for (auto& output : outputs_)
+    {
+        output.dest_ids.clear();
+        for (const auto& target : output.targets)
+        {
+            int id = resolve_id(target);
+            if (id == INVALID_INSTANCE_ID)
+            {
+                printf("错误: 线程 '%s' 的输出 '%s' 指向不存在的线程 '%s'。\n",
+                       instance_name_.c_str(), output.name.c_str(), target.c_str());
+                return ThreadWrapperError::ERROR_DEST_INVALID;
+            }
+            output.dest_ids.push_back(id);
+        }
+    }
+    return ThreadWrapperError::OK;
+}
+
+int ThreadWrapper::output_index(const std::string& name) const noexcept
+{
+    for (size_t i = 0; i < outputs_.size(); ++i)
+    {
+        if (outputs_[i].name == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+ThreadWrapperError ThreadWrapper::emit_envelope(size_t output, ThreadWrapperMessage message)
+{
+    if (output >= outputs_.size())
+    {
+        return ThreadWrapperError::INVALID_ARGS;
+    }
+
+    auto& app = ThreadWrapperApp::get_instance();
+    const auto deadline = std::chrono::steady_clock::time_point::max();
+    const std::vector<int>& dest_ids = outputs_[output].dest_ids;
+    ThreadWrapperError result = ThreadWrapperError::OK;
+    for (size_t i = 0; i < dest_ids.size(); ++i)
+    {
+        // Fan-out targets share the payload; the last one takes over the envelope.
+        ThreadWrapperMessage envelope = i + 1 < dest_ids.size() ? ThreadWrapperMessage(message) : std::move(message);
+        ThreadWrapperError ret = hold_emits_
+            ? send_or_hold(dest_ids[i], std::move(envelope))
+            : app.send_envelope_wait(dest_ids[i], std::move(envelope), deadline);
+        if (result == ThreadWrapperError::OK)
+        {
+            result = ret;
+        }
+    }
+    return result;
+}
+
+ThreadWrapperError ThreadWrapper::send_or_hold(int dest_id, ThreadWrapperMessage message)
+{
+    // Behind an envelope already held, so that each target still sees emits in order.
+    if (!held_emits_.empty())
+    {
+        held_emits_.push_back(HeldEmit{dest_id, std::move(message)});
+        return ThreadWrapperError::OK;
+    }
+    // send_envelope() consumes its argument even when the queue is full, so
+    // send a copy (a reference count on the payload) and keep the original.
+    ThreadWrapperError ret = ThreadWrapperApp::get_instance().send_envelope(dest_id, ThreadWrapperMessage(message));
+    if (ret == ThreadWrapperError::ENQUEUE_FAILED)
+    {
+        held_emits_.push_back(HeldEmit{dest_id, std::move(message)});
+        return ThreadWrapperError::OK;
+    }
+    return ret;
+}
+
+bool ThreadWrapper::flush_held_emits(int& dest_id, MessagePriority& priority)
+{
+    auto& app = ThreadWrapperApp::get_instance();
+    size_t sent = 0;
+    for (; sent < held_emits_.size(); ++sent)
+    {
+        HeldEmit& held = held_emits_[sent];
+        // A target that has gone away drops its envelope, as a blocking emit() would.
+        if (app.send_envelope(held.dest_id, ThreadWrapperMessage(held.message)) == ThreadWrapperError::ENQUEUE_FAILED)
+        {
+            dest_id = held.dest_id;
+            priority = held.message.priority;
+            break;
+        }
+    }
+    held_emits_.erase(held_emits_.begin(), held_emits_.begin() + static_cast<std::ptrdiff_t>(sent));
+    return held_emits_.empty();
+}
+
+ThreadWrapperError ThreadWrapper::watch_fd(int fd, FdEvents events)
+{
+    return event_loop_ ? event_loop_->watch(fd, events) : ThreadWrapperError::INVALID_ARGS;
+}
+
+ThreadWrapperError ThreadWrapper::unwatch_fd(int fd)
+{
+    return event_loop_ ? event_loop_->unwatch(fd) : ThreadWrapperError::INVALID_ARGS;
+}
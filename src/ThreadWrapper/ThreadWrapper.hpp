@@ -3,17 +3,33 @@
 
 #include <string>
 #include <memory>
+#include <functional>
+#include <vector>
+#include "ThreadWrapper/FdEventLoop.hpp"
 #include "ThreadWrapper/ThreadWrapperError.hpp"
+#include "ThreadWrapper/ThreadWrapperMessage.hpp"
 
 // OPTIMIZED: Replaced #define with a type-safe constant.
 static constexpr int INVALID_INSTANCE_ID = -1;
 
+/**
+ * @struct ThreadOutput
+ * @brief A named output of a thread and the threads it feeds, by name.
+ * More than one target makes it a fan-out: emit() delivers to all of them.
+ */
+struct ThreadOutput
+{
+    std::string name;
+    std::vector<std::string> targets;
+};
+
 /**
  * @class ThreadWrapper
  * @brief An abstract base class for a manageable thread.
  *
- * Users must inherit from this class and implement the process() method
- * to define the thread's message handling logic.
+ * Users must inherit from this class and implement process() (or
+ * process_message() for typed payloads) to define the thread's message
+ * handling logic.
  */
 class ThreadWrapper
 {
@@ -40,7 +56,79 @@ public:
      * @param msg_data A shared pointer to the message data.
      * @return 0 on success, non-zero on failure (which will terminate the thread).
      */
-    virtual ThreadWrapperError process(int msgId, std::shared_ptr<void> msg_data) = 0;
+    virtual ThreadWrapperError process(int msgId, std::shared_ptr<void> msg_data)
+    {
+        (void)msgId;
+        (void)msg_data;
+        return ThreadWrapperError::OK;
+    }
+
+    /**
+     * @brief Processes one message envelope.
+     * Override this to read typed payloads with msg.payload_as<T>() without
+     * any allocation. The default implementation forwards to process(),
+     * boxing an inline payload into a shared_ptr first.
+     * @param msg The envelope. The payload may be moved out.
+     * @return 0 on success, non-zero on failure (which will terminate the thread).
+     */
+    virtual ThreadWrapperError process_message(ThreadWrapperMessage& msg)
+    {
+        return process(msg.msg_id, msg.take_data());
+    }
+
+    /**
+     * @brief Processes a batch of messages drained from the queue in one go.
+     * The default implementation calls process_message() for each message in
+     * order; override it to amortize per-message work across the batch.
+     * @param messages The batch. Payloads may be moved out.
+     * @return 0 on success, non-zero on failure (which will terminate the thread).
+     */
+    virtual ThreadWrapperError process_batch(MessageSpan messages)
+    {
+        for (auto& msg : messages) {
+            ThreadWrapperError ret = process_message(msg);
+            if (ret != ThreadWrapperError::OK) {
+                return ret;
+            }
+        }
+        return ThreadWrapperError::OK;
+    }
+
+    /**
+     * @brief Called between polls while the mailbox is empty, in busy-poll mode only
+     * (see ThreadWrapperParam::busy_poll). Use it for polling work such as a NIC
+     * or shared-memory ring; keep it short, as it delays the next message.
+     * @return 0 to keep going, non-zero to terminate the thread.
+     */
+    virtual ThreadWrapperError on_idle()
+    {
+        return ThreadWrapperError::OK;
+    }
+
+    /**
+     * @brief Called once on the worker after the last message has been processed,
+     * before the thread is marked exited. Not called if initialize() failed.
+     * Use it to undo what initialize() or process() set up, e.g. cancel timers.
+     */
+    virtual void on_stop() {}
+
+    /**
+     * @brief Called when a descriptor registered with watch_fd() is readable
+     * (or hung up / in error), on the thread's own worker, between message batches.
+     * @return 0 on success, non-zero on failure (which will terminate the thread).
+     */
+    virtual ThreadWrapperError on_readable(int fd)
+    {
+        (void)fd;
+        return ThreadWrapperError::OK;
+    }
+
+    /// @brief Same for a descriptor watched for WRITABLE that can take more data.
+    virtual ThreadWrapperError on_writable(int fd)
+    {
+        (void)fd;
+        return ThreadWrapperError::OK;
+    }
 
     /// @brief Gets the unique ID assigned to this thread instance.
     int self_instance_id() const noexcept
@@ -56,7 +144,88 @@ public:
 
     ThreadWrapperError configure(int instance_id, const std::string& thread_name, int device_id);
 
+    /// @brief Gives the wrapper the worker's epoll loop for watch_fd(). Called by the manager.
+    void attach_event_loop(FdEventLoop* loop) noexcept { event_loop_ = loop; }
+
+    /// @brief Declares the outputs emit() sends to. Called before the thread is registered.
+    void declare_outputs(const std::vector<ThreadOutput>& outputs);
+    /**
+     * @brief Resolves every output target to a thread ID. Called once all threads
+     * started together are registered, and before initialize().
+     * @return ERROR_DEST_INVALID if a target does not exist.
+     */
+    ThreadWrapperError bind_outputs(const std::function<int(const std::string&)>& resolve_id);
+
+    /// @brief Makes emit() hold envelopes for a full target instead of blocking. Called by the manager of a POOLED wrapper.
+    void hold_emits_when_full() noexcept { hold_emits_ = true; }
+    /**
+     * @brief Retries, in order, the envelopes emit() held back. Called by the manager before the next batch.
+     * @return true once none is left; false if `dest_id` is still full, in lane `priority`.
+     */
+    bool flush_held_emits(int& dest_id, MessagePriority& priority);
+
+protected:
+    /**
+     * @brief Delivers readiness of `fd` to on_readable() / on_writable(); calling
+     * it again changes the events. Only on a thread started with
+     * ThreadWrapperParam::fd_events, and only from its own worker (initialize(),
+     * a handler or a callback).
+     * @return INVALID_ARGS if the thread has no event loop or `fd` is invalid.
+     */
+    ThreadWrapperError watch_fd(int fd, FdEvents events);
+    /// @brief Stops delivering events for `fd`. Call it before closing the descriptor.
+    ThreadWrapperError unwatch_fd(int fd);
+
+    /// @brief Index of the output called `name` for emit(), or -1. Look it up once, e.g. in initialize().
+    int output_index(const std::string& name) const noexcept;
+    size_t output_count() const noexcept { return outputs_.size(); }
+
+    /**
+     * @brief Sends a typed payload to every target of output `output` (see send()
+     * for how the payload is stored), blocking while a target's queue is full.
+     * A POOLED wrapper does not block its worker: the envelope for a full target
+     * is held, and the wrapper takes no further messages until it is delivered.
+     * The IDs were bound before initialize(), so no name is looked up here.
+     * @return OK, INVALID_ARGS for an unknown output, or the first send error;
+     *         the remaining targets are still tried.
+     */
+    template<typename T>
+    ThreadWrapperError emit(size_t output, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return emit_envelope(output, std::move(message));
+    }
+
+    /// @brief emit() on the first output, the only one of a linear stage.
+    template<typename T>
+    ThreadWrapperError emit(int msg_id, T&& value)
+    {
+        return emit(0, msg_id, std::forward<T>(value));
+    }
+
+    /// @brief Sends a fully built envelope to every target of output `output`.
+    ThreadWrapperError emit_envelope(size_t output, ThreadWrapperMessage message);
+
 private:
+    struct OutputPort {
+        std::string name;
+        std::vector<std::string> targets;
+        std::vector<int> dest_ids;
+    };
+
+    struct HeldEmit {
+        int dest_id;
+        ThreadWrapperMessage message;
+    };
+
+    ThreadWrapperError send_or_hold(int dest_id, ThreadWrapperMessage message);
+
+    std::vector<OutputPort> outputs_;
+    std::vector<HeldEmit> held_emits_; // POOLED only: emits waiting for room at their target.
+    bool hold_emits_ = false;
+    FdEventLoop* event_loop_ = nullptr;
     int instance_id_ = INVALID_INSTANCE_ID;
     std::string instance_name_;
     bool configured_ = false;
@@ -64,6 +233,42 @@ private:
 };
 
 
+/**
+ * @enum MailboxType
+ * @brief Selects the queue implementation backing a thread's mailbox.
+ */
+enum class MailboxType {
+    MUTEX,      // ThreadSafeQueue: one mutex taken on every push and pop.
+    LOCK_FREE,  // LockFreeQueue: MPSC ring, producers only wake a parked consumer.
+};
+
+/**
+ * @enum ReplicaDispatch
+ * @brief How messages sent to a replicated thread are spread over its replicas.
+ */
+enum class ReplicaDispatch {
+    ROUND_ROBIN,   // Rotate over the replicas.
+    LEAST_LOADED,  // Pick the replica with the shortest mailbox.
+};
+
+/**
+ * @enum ExecutionMode
+ * @brief Selects how a wrapper gets CPU time.
+ */
+enum class ExecutionMode {
+    DEDICATED,  // One std::thread per wrapper, blocking on its mailbox.
+    POOLED,     // Scheduled as an actor on the application's shared Executor.
+};
+
+/**
+ * @enum WaitPolicy
+ * @brief What a DEDICATED worker does when its mailbox runs empty.
+ */
+enum class WaitPolicy {
+    PARK,            // Sleep on a condition variable right away; no CPU used while idle.
+    SPIN_THEN_PARK,  // Spin, then yield, then sleep; the spin time adapts to the arrival rate.
+};
+
 /**
  * @struct ThreadWrapperParam
  * @brief Parameters for creating a new thread within the application.
@@ -75,6 +280,41 @@ struct ThreadWrapperParam
     int device_id = 0;
     int thread_instance_id = INVALID_INSTANCE_ID;
     uint32_t queue_size = 256;
+    MailboxType mailbox_type = MailboxType::LOCK_FREE;
+    // Maximum number of messages the worker drains per queue access and hands to process_batch().
+    uint32_t batch_size = 16;
+    // Number of worker threads behind this name. Replica 0 runs `thread_instance`,
+    // the others run instances made by `replica_factory` (required when replicas > 1).
+    uint32_t replicas = 1;
+    std::function<std::unique_ptr<ThreadWrapper>()> replica_factory;
+    ReplicaDispatch replica_dispatch = ReplicaDispatch::ROUND_ROBIN;
+    // POOLED suits many mostly idle wrappers: no stack or OS thread of their own,
+    // but process() must not block for long.
+    ExecutionMode execution_mode = ExecutionMode::DEDICATED;
+    // CPUs to pin the worker thread to before initialize() runs (DEDICATED mode only).
+    // Empty means no pinning, or all CPUs of `numa_node` if that is set.
+    std::vector<int> cpu_affinity;
+    // NUMA node for the thread's mailbox and batch buffer, and default CPU set.
+    // -1 derives it from the first CPU in cpu_affinity, or leaves placement to the OS.
+    int numa_node = -1;
+    // HIGH priority lane: its own capacity, and 0 for strict priority or N to let
+    // one waiting NORMAL message through after every N HIGH ones.
+    uint32_t high_priority_capacity = 64;
+    uint32_t high_priority_weight = 0;
+    // SPIN_THEN_PARK trades idle CPU for wake-up latency; max_spin_us caps the adaptive spin time.
+    WaitPolicy wait_policy = WaitPolicy::PARK;
+    uint32_t max_spin_us = 50;
+    // DEDICATED only: never sleep. The worker spins on a lock-free mailbox without
+    // any syscall and calls on_idle() between polls. Meant for a stage pinned to an
+    // isolated core (cpu_affinity); it uses that core fully even with no traffic.
+    bool busy_poll = false;
+    // DEDICATED only: the worker waits in epoll on its mailbox (signalled through an
+    // eventfd) and on the descriptors the wrapper registers with watch_fd(), so I/O
+    // is handled on the same thread as messages. Ignored together with busy_poll.
+    bool fd_events = false;
+    // Named outputs for ThreadWrapper::emit(), bound to thread IDs when the threads start.
+    // Usually filled in by PipelineGraph.
+    std::vector<ThreadOutput> outputs;
 };
 
 #endif // THREADWRAPPER_HPP
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "ThreadWrapper/ThreadWrapperApp.hpp"
+#include <algorithm>
 #include <cstdio>
+#include <iterator>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 
 ThreadWrapperApp& ThreadWrapperApp::get_instance()
@@ -18,60 +22,139 @@ ThreadWrapperError send_message(int dest, int msg_id, std::shared_ptr<void> data
     return ThreadWrapperApp::get_instance().send_message(dest, msg_id, std::move(data));
 }
 
+ThreadWrapperError send_message(int dest, int msg_id, std::shared_ptr<void> data, MessagePriority priority)
+{
+    return ThreadWrapperApp::get_instance().send_message(dest, msg_id, std::move(data), priority);
+}
+
+ThreadWrapperError send_message_wait(int dest, int msg_id, std::shared_ptr<void> data)
+{
+    return ThreadWrapperApp::get_instance().send_message_wait(dest, msg_id, std::move(data));
+}
+
+ThreadWrapperError send_message_for(int dest, int msg_id, std::shared_ptr<void> data,
+                                    std::chrono::steady_clock::duration timeout)
+{
+    return ThreadWrapperApp::get_instance().send_message_for(dest, msg_id, std::move(data), timeout);
+}
+
+TimerHandle send_message_after(int dest, int msg_id, std::shared_ptr<void> data,
+                               std::chrono::steady_clock::duration delay)
+{
+    return ThreadWrapperApp::get_instance().send_message_after(dest, msg_id, std::move(data), delay);
+}
+
+TimerHandle schedule_periodic(int dest, int msg_id, std::shared_ptr<void> data,
+                              std::chrono::steady_clock::duration period)
+{
+    return ThreadWrapperApp::get_instance().schedule_periodic(dest, msg_id, std::move(data), period);
+}
+
+bool cancel_timer(TimerHandle handle)
+{
+    return ThreadWrapperApp::get_instance().cancel_timer(handle);
+}
+
+MulticastResult multicast(const std::vector<int>& dest_ids, int msg_id, std::shared_ptr<void> data)
+{
+    return ThreadWrapperApp::get_instance().multicast(dest_ids, msg_id, std::move(data));
+}
+
+MulticastResult broadcast(const std::string& group_name, int msg_id, std::shared_ptr<void> data)
+{
+    return ThreadWrapperApp::get_instance().broadcast(group_name, msg_id, std::move(data));
+}
+
 int get_thread_wrapper_id_by_name(const std::string& thread_name)
 {
     return ThreadWrapperApp::get_instance().get_thread_wrapper_id_by_name(thread_name);
 }
 
+const CompiledRoute* compile_route(const std::vector<std::string>& thread_names)
+{
+    return ThreadWrapperApp::get_instance().compile_route(thread_names);
+}
+
 
 ThreadWrapperApp::ThreadWrapperApp() 
 {
-    auto main_thread_mgr = std::make_unique<ThreadWrapperMgr>(nullptr, "main", 1);
+    ThreadWrapperParam main_params;
+    main_params.thread_instance_name = "main";
+    main_params.queue_size = 256; // Used once main_mailbox() opens it.
+    auto main_thread_mgr = std::make_unique<ThreadWrapperMgr>(nullptr, main_params);
     main_thread_mgr->set_status(ThreadWrapperStatus::RUNNING);
-    thread_mgr_list_.push_back(std::move(main_thread_mgr));
+    registry_.add(std::move(main_thread_mgr));
+    bind_name(main_params.thread_instance_name, MAIN_THREAD_ID);
 }
 
 ThreadWrapperApp::~ThreadWrapperApp()
 {
+    // No timer may fire into a thread that is being torn down.
+    timer_wheel_.reset();
     release_threads();
 }
 
-ThreadWrapperError ThreadWrapperApp::start(std::vector<ThreadWrapperParam>& thread_param_list)
+ThreadWrapperError ThreadWrapperApp::start(std::vector<ThreadWrapperParam>& thread_param_list,
+                                           std::chrono::steady_clock::duration init_timeout)
 {
-    // *** FIX: Record the starting index of the new threads we are about to create. ***
-    const size_t start_index = thread_mgr_list_.size();
+    reap_rollbacks();
+
+    // Other start() calls may register threads concurrently, so remember exactly which ones are ours;
+    // a failure rolls back these and nothing else.
+    std::vector<ThreadWrapperMgr*> new_mgrs;
+    std::vector<int> new_ids;
+    new_mgrs.reserve(thread_param_list.size());
+    new_ids.reserve(thread_param_list.size());
 
     for (auto& params : thread_param_list) 
     {
-        int instance_id = create_thread_wrapper_mgr(
-            std::move(params.thread_instance),
-            params.thread_instance_name,
-            params.device_id,
-            params.queue_size);
+        int instance_id = create_thread_wrapper_mgr(params, new_mgrs);
 
         if (instance_id == INVALID_INSTANCE_ID) 
         {
-            // If creation fails, we should ideally roll back, but for now, we stop everything.
             printf("错误: 创建线程管理器 '%s' 失败。请检查线程名是否重复。\n", params.thread_instance_name.c_str());
-            release_threads();
+            stop_threads(new_ids);
             return ThreadWrapperError::ERROR;
         }
         params.thread_instance_id = instance_id;
+        new_ids.push_back(instance_id);
     }
 
-    // *** FIX: Iterate only over the NEW threads that were added in THIS call. ***
-    for (size_t i = start_index; i < thread_mgr_list_.size(); ++i) 
+    // Every thread of this batch is registered now, so outputs may name any of them.
+    auto resolve_id = [this](const std::string& name) { return get_thread_wrapper_id_by_name(name); };
+    for (auto* mgr : new_mgrs) 
     {
-        thread_mgr_list_[i]->start_thread();
+        if (mgr->bind_outputs(resolve_id) != ThreadWrapperError::OK) 
+        {
+            stop_threads(new_ids);
+            return ThreadWrapperError::ERROR_DEST_INVALID;
+        }
+    }
+
+    // All threads initialize in parallel; waiting for each in turn against the
+    // one deadline bounds the whole batch, not every thread separately.
+    for (auto* mgr : new_mgrs) 
+    {
+        mgr->start_thread();
     }
 
-    // *** FIX: Wait only for the NEW threads to initialize. ***
-    for (size_t i = start_index; i < thread_mgr_list_.size(); ++i) 
+    const auto deadline = init_timeout > std::chrono::steady_clock::duration::zero()
+        ? std::chrono::steady_clock::now() + init_timeout
+        : std::chrono::steady_clock::time_point::max();
+    for (auto* mgr : new_mgrs) 
     {
-        if (thread_mgr_list_[i]->wait_for_init() != ThreadWrapperError::OK) 
+        ThreadWrapperError ret = mgr->wait_for_init(deadline);
+        if (ret == ThreadWrapperError::TIMEOUT) 
         {
-            printf("错误: 线程 '%s' 初始化失败。\n", thread_mgr_list_[i]->get_thread_name().c_str());
-            release_threads(); // Stop all threads on failure
+            printf("错误: 线程 '%s' 初始化超时。\n", mgr->get_thread_name().c_str());
+            roll_back_in_background(new_ids);
+            return ret;
+        }
+        if (ret != ThreadWrapperError::OK) 
+        {
+            // Its siblings may still be initializing; do not wait for them either.
+            printf("错误: 线程 '%s' 初始化失败。\n", mgr->get_thread_name().c_str());
+            roll_back_in_background(new_ids);
             return ThreadWrapperError::START_THREAD_FAILED;
         }
     }
@@ -79,138 +162,772 @@ ThreadWrapperError ThreadWrapperApp::start(std::vector<ThreadWrapperParam>& thre
     return ThreadWrapperError::OK;
 }
 
-void ThreadWrapperApp::stop()
+void ThreadWrapperApp::roll_back_in_background(const std::vector<int>& thread_ids)
 {
-    release_threads();
+    // Some of these threads are still inside initialize(), which cannot be
+    // interrupted. Free their names now, so the caller may retry at once, and
+    // leave joining and unregistering them to a thread of their own.
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    std::vector<ThreadWrapperMgr*> mgrs;
+    std::vector<int> removed_ids;
+    collect_threads(thread_ids, mgrs, removed_ids);
+    std::unordered_set<int> removed(removed_ids.begin(), removed_ids.end());
+    for (auto it = name_index_.begin(); it != name_index_.end();) 
+    {
+        it = removed.count(it->second) ? name_index_.erase(it) : std::next(it);
+    }
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    std::thread thread([this, mgrs, removed_ids, done]() {
+        stop_and_join(mgrs, StopMode::abort_now());
+        {
+            std::lock_guard<std::mutex> lock(app_mutex_);
+            unregister(removed_ids);
+        }
+        done->store(true, std::memory_order_release);
+    });
+    rollbacks_.push_back(Rollback{std::move(thread), std::move(done)});
+}
+
+void ThreadWrapperApp::reap_rollbacks()
+{
+    // Joins rollbacks that have finished, so repeated failed starts do not pile
+    // up threads until release. Unfinished ones are left for a later call.
+    std::vector<Rollback> finished;
+    {
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        auto first_done = std::stable_partition(rollbacks_.begin(), rollbacks_.end(), [](const Rollback& rollback) {
+            return !rollback.done->load(std::memory_order_acquire);
+        });
+        std::move(first_done, rollbacks_.end(), std::back_inserter(finished));
+        rollbacks_.erase(first_done, rollbacks_.end());
+    }
+    for (auto& rollback : finished) 
+    {
+        rollback.thread.join();
+    }
+}
+
+StopReport ThreadWrapperApp::stop(StopMode mode)
+{
+    return release_threads(mode);
+}
+
+StopReport ThreadWrapperApp::stop_threads(const std::vector<int>& thread_ids, StopMode mode)
+{
+    std::vector<ThreadWrapperMgr*> mgrs;
+    std::vector<int> removed_ids;
+    {
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        collect_threads(thread_ids, mgrs, removed_ids);
+    }
+
+    StopReport report = stop_and_join(mgrs, mode);
+
+    // Free the names and slots. The IDs go stale: sends to them now fail
+    // with ERROR_DEST_INVALID even after a new thread takes the slot.
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    unregister(removed_ids);
+    return report;
 }
 
-void ThreadWrapperApp::stop_threads(const std::vector<int>& thread_ids)
+void ThreadWrapperApp::collect_threads(const std::vector<int>& thread_ids, std::vector<ThreadWrapperMgr*>& mgrs,
+                                       std::vector<int>& removed_ids)
 {
-    // Step 1: Send stop signal (poison pill) to specified threads
-    for (int id : thread_ids) {
-        if (id > 0 && static_cast<size_t>(id) < thread_mgr_list_.size()) {
-            auto& mgr = thread_mgr_list_[id];
-            if (mgr && mgr->get_status() == ThreadWrapperStatus::RUNNING) {
-                mgr->set_status(ThreadWrapperStatus::EXITING);
-                mgr->push_message_to_queue(nullptr); // Send poison pill
+    for (int requested_id : thread_ids) {
+        if (requested_id <= MAIN_THREAD_ID || is_external_mailbox(requested_id)) {
+            continue;
+        }
+        // A replica's own ID ("<name>#<i>") stops its whole group, which dispatches to every replica.
+        const int id = replica_group_of(requested_id);
+        if (std::find(removed_ids.begin(), removed_ids.end(), id) != removed_ids.end()) {
+            continue; // Listed twice, or through several replicas.
+        }
+        if (ReplicaGroup* group = registry_.group_at(id)) {
+            for (ThreadWrapperMgr* replica : group->replicas()) {
+                replica->pin();
+                mgrs.push_back(replica);
+            }
+            for (int replica_id : registry_.ids()) {
+                ThreadWrapperMgr* replica = registry_.at(replica_id);
+                if (replica && std::find(group->replicas().begin(), group->replicas().end(), replica) !=
+                                   group->replicas().end()) {
+                    removed_ids.push_back(replica_id);
+                }
             }
+            removed_ids.push_back(id);
+        } else if (ThreadWrapperMgr* mgr = registry_.at(id)) {
+            mgr->pin();
+            mgrs.push_back(mgr);
+            removed_ids.push_back(id);
+        }
+    }
+}
+
+int ThreadWrapperApp::replica_group_of(int id) const
+{
+    const ThreadWrapperMgr* mgr = registry_.at(id);
+    if (!mgr) {
+        return id;
+    }
+    for (int group_id : registry_.ids()) {
+        const ReplicaGroup* group = registry_.group_at(group_id);
+        if (group && std::find(group->replicas().begin(), group->replicas().end(), mgr) != group->replicas().end()) {
+            return group_id;
         }
     }
+    return id;
+}
+
+StopReport ThreadWrapperApp::release_threads(StopMode mode)
+{
+    // Rollbacks still in progress finish first; they take app_mutex_ themselves.
+    std::vector<Rollback> rollbacks;
+    {
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        rollbacks.swap(rollbacks_);
+    }
+    for (auto& rollback : rollbacks) 
+    {
+        rollback.thread.join();
+    }
 
-    // Step 2: Wait for specified threads to join
-    for (int id : thread_ids) {
-        if (id > 0 && static_cast<size_t>(id) < thread_mgr_list_.size()) {
-            if (thread_mgr_list_[id]) {
-                thread_mgr_list_[id]->join_thread();
+    std::vector<ThreadWrapperMgr*> mgrs;
+    std::vector<int> removed_ids;
+    {
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        for (int id : registry_.ids()) 
+        {
+            if (id == MAIN_THREAD_ID) 
+            {
+                continue;
+            }
+            removed_ids.push_back(id);
+            if (ThreadWrapperMgr* mgr = registry_.at(id)) 
+            {
+                mgr->pin();
+                mgrs.push_back(mgr); // Replica groups have no thread of their own.
             }
         }
     }
 
-    // Note: This implementation does not remove the thread managers from thread_mgr_list_
-    // to keep thread IDs stable. A more complex implementation might mark them as 'reusable'.
-    // For now, we assume tasks are created and destroyed, but not recreated with the same IDs.
+    StopReport report = stop_and_join(mgrs, mode);
+
+    // Unpublish everything but "main"; remove() waits until concurrent senders let go.
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    external_mailboxes_.clear();
+    unregister(removed_ids);
+    return report;
 }
 
-void ThreadWrapperApp::release_threads()
+StopReport ThreadWrapperApp::stop_and_join(const std::vector<ThreadWrapperMgr*>& mgrs, StopMode mode)
 {
-    for (size_t i = MAIN_THREAD_ID + 1; i < thread_mgr_list_.size(); ++i) 
+    // The managers were pinned when collected, so a concurrent stop of the
+    // same threads cannot destroy them under us.
+    // Step 1: Signal every thread, so they all drain or exit at the same time.
+    // A thread that is already stopping takes the request too: abort_now cuts a drain short.
+    for (auto* mgr : mgrs) 
     {
-        if (thread_mgr_list_[i] && thread_mgr_list_[i]->get_status() == ThreadWrapperStatus::RUNNING) 
+        // READY: still initializing (a rolled-back start); it exits as soon as initialize() returns.
+        ThreadWrapperStatus status = mgr->get_status();
+        if (status == ThreadWrapperStatus::RUNNING) 
         {
-            thread_mgr_list_[i]->set_status(ThreadWrapperStatus::EXITING);
-            thread_mgr_list_[i]->push_message_to_queue(nullptr);
+            mgr->set_status(ThreadWrapperStatus::EXITING);
+        }
+        if (status != ThreadWrapperStatus::EXITED && status != ThreadWrapperStatus::ERROR) 
+        {
+            mgr->push_stop_message(mode);
         }
     }
 
-    for (size_t i = MAIN_THREAD_ID + 1; i < thread_mgr_list_.size(); ++i) 
+    // Step 2: Join them; this takes as long as the slowest one.
+    StopReport report;
+    for (auto* mgr : mgrs) 
+    {
+        mgr->join_thread();
+        report += mgr->get_stop_report();
+        mgr->unpin();
+    }
+    return report;
+}
+
+void ThreadWrapperApp::unregister(const std::vector<int>& ids)
+{
+    std::unordered_set<int> removed(ids.begin(), ids.end());
+    for (auto it = name_index_.begin(); it != name_index_.end();) 
+    {
+        it = removed.count(it->second) ? name_index_.erase(it) : std::next(it);
+    }
+    registry_.remove(ids);
+}
+
+void ThreadWrapperApp::bind_name(const std::string& name, int id)
+{
+    // A name coming back after a restart takes over its old hops and group seats.
+    name_index_.emplace(name, id);
+    for (auto& entry : routes_) 
     {
-        if (thread_mgr_list_[i]) 
+        entry.second->rebind(name, id);
+    }
+    for (auto& entry : broadcast_groups_) 
+    {
+        entry.second->rebind(name, id);
+    }
+}
+
+bool ThreadWrapperApp::is_external_mailbox(int id) const
+{
+    return std::any_of(external_mailboxes_.begin(), external_mailboxes_.end(),
+                       [id](const std::unique_ptr<ExternalMailbox>& mailbox) { return mailbox->id() == id; });
+}
+
+int ThreadWrapperApp::create_thread_wrapper_mgr(ThreadWrapperParam& params, std::vector<ThreadWrapperMgr*>& created)
+{
+    const uint32_t replicas = params.replicas;
+    if (!params.thread_instance || params.thread_instance_name.empty() || replicas == 0 ||
+        (replicas > 1 && !params.replica_factory)) 
+    {
+        return INVALID_INSTANCE_ID;
+    }
+
+    // Build every replica's instance before taking the lock; the factory is user code.
+    std::vector<std::unique_ptr<ThreadWrapper>> instances;
+    std::vector<std::string> names;
+    if (replicas == 1) 
+    {
+        names.push_back(params.thread_instance_name);
+    } 
+    else 
+    {
+        instances.reserve(replicas);
+        for (uint32_t i = 0; i < replicas; ++i) 
         {
-            thread_mgr_list_[i]->join_thread();
+            instances.push_back(i == 0 ? std::move(params.thread_instance) : params.replica_factory());
+            if (!instances.back()) 
+            {
+                return INVALID_INSTANCE_ID;
+            }
+            names.push_back(params.thread_instance_name + "#" + std::to_string(i));
         }
+        names.push_back(params.thread_instance_name);
     }
 
-    thread_mgr_list_.clear();
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    for (const auto& name : names) 
+    {
+        if (name_index_.find(name) != name_index_.end()) 
+        {
+            return INVALID_INSTANCE_ID;
+        }
+    }
+    if (params.execution_mode == ExecutionMode::POOLED && !executor_) 
+    {
+        executor_ = std::make_unique<Executor>();
+    }
+
+    if (replicas == 1) 
+    {
+        int instance_id = registry_.next_id();
+        if (instance_id == INVALID_INSTANCE_ID ||
+            params.thread_instance->configure(instance_id, params.thread_instance_name, params.device_id) != ThreadWrapperError::OK) 
+        {
+            return INVALID_INSTANCE_ID;
+        }
+        params.thread_instance->declare_outputs(params.outputs);
+        registry_.add(std::make_unique<ThreadWrapperMgr>(std::move(params.thread_instance), params,
+                                                        params.thread_instance_name, executor_.get()));
+        bind_name(params.thread_instance_name, instance_id);
+        created.push_back(registry_.at(instance_id));
+        return instance_id;
+    }
+
+    // The caller only learns about replicas once the whole group is in place, so
+    // replicas registered before a failure are unregistered here.
+    std::vector<ThreadWrapperMgr*> members;
+    std::vector<int> member_ids;
+    for (uint32_t i = 0; i < replicas; ++i) 
+    {
+        int replica_id = registry_.next_id();
+        if (replica_id == INVALID_INSTANCE_ID ||
+            instances[i]->configure(replica_id, names[i], params.device_id) != ThreadWrapperError::OK) 
+        {
+            unregister(member_ids);
+            return INVALID_INSTANCE_ID;
+        }
+        instances[i]->declare_outputs(params.outputs);
+        registry_.add(std::make_unique<ThreadWrapperMgr>(std::move(instances[i]), params, names[i], executor_.get()));
+        bind_name(names[i], replica_id);
+        members.push_back(registry_.at(replica_id));
+        member_ids.push_back(replica_id);
+    }
+
+    int group_id = registry_.add_group(std::make_unique<ReplicaGroup>(members, params.replica_dispatch));
+    if (group_id == INVALID_INSTANCE_ID) 
+    {
+        unregister(member_ids);
+        return INVALID_INSTANCE_ID;
+    }
+    created.insert(created.end(), members.begin(), members.end());
+    bind_name(params.thread_instance_name, group_id);
+    return group_id;
 }
 
-int ThreadWrapperApp::create_thread_wrapper_mgr(
-    std::unique_ptr<ThreadWrapper> thread_instance, const std::string& instance_name, int device_id, uint32_t msg_queue_size)
+int ThreadWrapperApp::get_thread_wrapper_id_by_name(const std::string& thread_name) const
 {
-    if (!thread_instance || !is_name_unique(instance_name)) 
+    if (thread_name.empty()) 
     {
         return INVALID_INSTANCE_ID;
     }
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    auto it = name_index_.find(thread_name);
+    return it != name_index_.end() ? it->second : INVALID_INSTANCE_ID;
+}
 
-    int instance_id = thread_mgr_list_.size();
-    if (thread_instance->configure(instance_id, instance_name, device_id) != ThreadWrapperError::OK) 
+const CompiledRoute* ThreadWrapperApp::compile_route(const std::vector<std::string>& thread_names)
+{
+    std::vector<int> hops;
+    hops.reserve(thread_names.size());
+    for (const auto& name : thread_names) 
     {
-        return INVALID_INSTANCE_ID;
+        int id = get_thread_wrapper_id_by_name(name);
+        if (id == INVALID_INSTANCE_ID) 
+        {
+            printf("错误: 路由中的线程 '%s' 不存在。\n", name.c_str());
+            return nullptr;
+        }
+        hops.push_back(id);
     }
 
-    auto th_mgr = std::make_unique<ThreadWrapperMgr>(std::move(thread_instance), instance_name, msg_queue_size);
-    thread_mgr_list_.push_back(std::move(th_mgr));
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    auto& route = routes_[thread_names];
+    if (!route) 
+    {
+        route = std::make_unique<CompiledRoute>(thread_names, hops);
+    }
+    return route.get();
+}
 
-    return instance_id;
+ThreadWrapperError ThreadWrapperApp::send_message(int dest_id, int msg_id, std::shared_ptr<void> data)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+
+    return send_envelope(dest_id, std::move(message));
 }
 
-bool ThreadWrapperApp::is_name_unique(const std::string& thread_name) const
+ThreadWrapperError ThreadWrapperApp::send_message(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                                  MessagePriority priority)
 {
-    if (thread_name.empty()) 
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.priority = priority;
+    message.data = std::move(data);
+
+    return send_envelope(dest_id, std::move(message));
+}
+
+ThreadWrapperError ThreadWrapperApp::send_envelope(int dest_id, ThreadWrapperMessage message)
+{
+    ThreadRegistry::ReadGuard guard(registry_);
+    ThreadWrapperMgr* mgr = resolve_dest(guard, dest_id);
+    if (!mgr) 
     {
-        return false;
+        return ThreadWrapperError::ERROR_DEST_INVALID;
     }
-    for (const auto& mgr : thread_mgr_list_) 
+
+    message.dest = dest_id;
+    return mgr->push_message_to_queue(std::move(message));
+}
+
+MulticastResult ThreadWrapperApp::multicast(const std::vector<int>& dest_ids, int msg_id,
+                                            std::shared_ptr<void> data)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+
+    return multicast_envelope(dest_ids, std::move(message));
+}
+
+MulticastResult ThreadWrapperApp::multicast_envelope(const std::vector<int>& dest_ids,
+                                                     ThreadWrapperMessage message)
+{
+    return multicast_to(dest_ids.size(), [&dest_ids](size_t i) { return dest_ids[i]; }, std::move(message));
+}
+
+template <typename DestAt>
+MulticastResult ThreadWrapperApp::multicast_to(size_t count, DestAt dest_at, ThreadWrapperMessage message)
+{
+    MulticastResult result;
+    ThreadRegistry::ReadGuard guard(registry_);
+    for (size_t i = 0; i < count; ++i) 
     {
-        if (mgr && mgr->get_thread_name() == thread_name) 
+        const int dest_id = dest_at(i);
+        ThreadWrapperMgr* mgr = resolve_dest(guard, dest_id);
+        if (!mgr) 
         {
-            return false;
+            result.failures.emplace_back(dest_id, ThreadWrapperError::ERROR_DEST_INVALID);
+            continue;
+        }
+
+        // Every destination gets a copy of the template; the last one takes it over.
+        ThreadWrapperError ret;
+        if (i + 1 < count) 
+        {
+            ThreadWrapperMessage copy = message;
+            copy.dest = dest_id;
+            ret = mgr->push_message_to_queue(std::move(copy));
+        }
+        else 
+        {
+            message.dest = dest_id;
+            ret = mgr->push_message_to_queue(std::move(message));
+        }
+        if (ret == ThreadWrapperError::OK) 
+        {
+            ++result.delivered;
+        }
+        else 
+        {
+            result.failures.emplace_back(dest_id, ret);
         }
     }
-    return true;
+    return result;
 }
 
+const BroadcastGroup* ThreadWrapperApp::create_broadcast_group(const std::string& group_name,
+                                                               const std::vector<std::string>& thread_names)
+{
+    std::vector<int> members;
+    members.reserve(thread_names.size());
+    for (const auto& name : thread_names) 
+    {
+        int id = get_thread_wrapper_id_by_name(name);
+        if (id == INVALID_INSTANCE_ID) 
+        {
+            printf("错误: 广播组 '%s' 中的线程 '%s' 不存在。\n", group_name.c_str(), name.c_str());
+            return nullptr;
+        }
+        members.push_back(id);
+    }
+
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    auto& group = broadcast_groups_[group_name];
+    if (group) 
+    {
+        printf("错误: 广播组 '%s' 已存在。\n", group_name.c_str());
+        return nullptr;
+    }
+    group = std::make_unique<BroadcastGroup>(group_name, thread_names, members);
+    return group.get();
+}
 
-int ThreadWrapperApp::get_thread_wrapper_id_by_name(const std::string& thread_name) const
+const BroadcastGroup* ThreadWrapperApp::get_broadcast_group(const std::string& group_name) const
 {
-    if (thread_name.empty()) 
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    auto it = broadcast_groups_.find(group_name);
+    return it != broadcast_groups_.end() ? it->second.get() : nullptr;
+}
+
+MulticastResult ThreadWrapperApp::broadcast(const BroadcastGroup& group, int msg_id, std::shared_ptr<void> data)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+
+    return multicast_to(group.size(), [&group](size_t i) { return group.member(i); }, std::move(message));
+}
+
+MulticastResult ThreadWrapperApp::broadcast(const std::string& group_name, int msg_id, std::shared_ptr<void> data)
+{
+    const BroadcastGroup* group = get_broadcast_group(group_name);
+    if (!group) 
     {
-        return INVALID_INSTANCE_ID;
+        MulticastResult result;
+        result.failures.emplace_back(INVALID_INSTANCE_ID, ThreadWrapperError::ERROR_DEST_INVALID);
+        return result;
+    }
+    return broadcast(*group, msg_id, std::move(data));
+}
+
+TimerHandle ThreadWrapperApp::send_message_after(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                                 std::chrono::steady_clock::duration delay)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+    return add_timer(dest_id, std::move(message), delay, std::chrono::steady_clock::duration::zero());
+}
+
+TimerHandle ThreadWrapperApp::send_envelope_after(int dest_id, ThreadWrapperMessage message,
+                                                  std::chrono::steady_clock::duration delay)
+{
+    return add_timer(dest_id, std::move(message), delay, std::chrono::steady_clock::duration::zero());
+}
+
+TimerHandle ThreadWrapperApp::schedule_periodic(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                                std::chrono::steady_clock::duration period)
+{
+    if (period <= std::chrono::steady_clock::duration::zero())
+    {
+        return TimerHandle();
     }
-    for (size_t i = 0; i < thread_mgr_list_.size(); ++i) 
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+    return add_timer(dest_id, std::move(message), period, period);
+}
+
+TimerHandle ThreadWrapperApp::add_timer(int dest_id, ThreadWrapperMessage message,
+                                        std::chrono::steady_clock::duration delay,
+                                        std::chrono::steady_clock::duration period)
+{
+    {
+        ThreadRegistry::ReadGuard guard(registry_);
+        if (!resolve_dest(guard, dest_id))
+        {
+            return TimerHandle();
+        }
+    }
+
+    TimerWheel* wheel = nullptr;
     {
-        if (thread_mgr_list_[i] && thread_mgr_list_[i]->get_thread_name() == thread_name) 
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        if (!timer_wheel_)
         {
-            return static_cast<int>(i);
+            timer_wheel_ = std::make_unique<TimerWheel>(
+                [this](int dest, ThreadWrapperMessage message) { return send_envelope(dest, std::move(message)); });
         }
+        wheel = timer_wheel_.get();
     }
-    return INVALID_INSTANCE_ID;
+
+    return wheel->add(dest_id, std::move(message), delay, period);
 }
 
-ThreadWrapperError ThreadWrapperApp::send_message(int dest_id, int msg_id, std::shared_ptr<void> data)
+bool ThreadWrapperApp::cancel_timer(TimerHandle handle)
+{
+    TimerWheel* wheel = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(app_mutex_);
+        wheel = timer_wheel_.get();
+    }
+    return wheel && handle.valid() && wheel->cancel(handle);
+}
+
+bool ThreadWrapperApp::notify_when_space(int dest_id, MessagePriority priority, std::function<void()> callback)
+{
+    ThreadRegistry::ReadGuard guard(registry_);
+    ThreadWrapperMgr* mgr = resolve_dest(guard, dest_id);
+    return mgr && mgr->notify_when_space(priority, std::move(callback));
+}
+
+ThreadWrapperMgr* ThreadWrapperApp::resolve_dest(const ThreadRegistry::ReadGuard& guard, int dest_id) const noexcept
+{
+    // "main" has no consumer until main_mailbox() opens its mailbox.
+    if (dest_id < MAIN_THREAD_ID ||
+        (dest_id == MAIN_THREAD_ID && !main_mailbox_open_.load(std::memory_order_acquire)))
+    {
+        return nullptr;
+    }
+    return guard.resolve(dest_id);
+}
+
+ThreadWrapperError ThreadWrapperApp::reply_envelope(const ThreadWrapperMessage& request, ThreadWrapperMessage message)
 {
-    if (dest_id <= 0 || static_cast<size_t>(dest_id) >= thread_mgr_list_.size()) 
+    if (request.correlation_id == 0)
     {
         return ThreadWrapperError::ERROR_DEST_INVALID;
     }
+    message.kind = MessageKind::REPLY;
+    message.correlation_id = request.correlation_id;
+    if (request.reply_to != REPLY_TO_PENDING)
+    {
+        return send_envelope(request.reply_to, std::move(message));
+    }
 
-    auto p_message = std::make_shared<ThreadWrapperMessage>();
-    p_message->dest = dest_id;
-    p_message->msg_id = msg_id;
-    p_message->data = std::move(data);
+    Reply reply;
+    reply.message = std::move(message);
+    return pending_replies_.complete(request.correlation_id, std::move(reply)) ? ThreadWrapperError::OK
+                                                                               : ThreadWrapperError::ERROR_DEST_INVALID;
+}
 
-    return thread_mgr_list_[dest_id]->push_message_to_queue(p_message);
+ThreadWrapperError ThreadWrapperApp::abandon_request(const ThreadWrapperMessage& request)
+{
+    if (request.kind != MessageKind::DATA || request.correlation_id == 0)
+    {
+        return ThreadWrapperError::ERROR_DEST_INVALID;
+    }
+    if (request.reply_to != REPLY_TO_PENDING)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = REQUEST_DROPPED_MSG_ID;
+        return reply_envelope(request, std::move(message));
+    }
+
+    Reply reply;
+    reply.error = ThreadWrapperError::THREAD_ABNORMAL;
+    return pending_replies_.complete(request.correlation_id, std::move(reply)) ? ThreadWrapperError::OK
+                                                                               : ThreadWrapperError::ERROR_DEST_INVALID;
+}
+
+ReplyFuture ThreadWrapperApp::send_request_envelope(int dest_id, ThreadWrapperMessage message)
+{
+    // Register first: the reply may be back before send_envelope() returns.
+    auto state = std::make_shared<PendingReplies::State>();
+    const uint32_t id = pending_replies_.add(state);
+    message.correlation_id = id;
+    message.reply_to = REPLY_TO_PENDING;
+
+    ThreadWrapperError ret = send_envelope(dest_id, std::move(message));
+    if (ret != ThreadWrapperError::OK)
+    {
+        pending_replies_.cancel(id);
+        Reply reply;
+        reply.error = ret;
+        state->set(std::move(reply));
+    }
+    return ReplyFuture(&pending_replies_, id, std::move(state));
+}
+
+ThreadWrapperError ThreadWrapperApp::send_request_envelope(int dest_id, ThreadWrapperMessage message,
+                                                           ReplyCallback callback, uint32_t* request_id)
+{
+    const uint32_t id = pending_replies_.add(std::move(callback));
+    message.correlation_id = id;
+    message.reply_to = REPLY_TO_PENDING;
+
+    ThreadWrapperError ret = send_envelope(dest_id, std::move(message));
+    if (ret != ThreadWrapperError::OK)
+    {
+        pending_replies_.cancel(id);
+        return ret;
+    }
+    if (request_id)
+    {
+        *request_id = id;
+    }
+    return ThreadWrapperError::OK;
+}
+
+bool ThreadWrapperApp::cancel_request(uint32_t request_id)
+{
+    return pending_replies_.cancel(request_id);
+}
+
+ExternalMailbox& ThreadWrapperApp::main_mailbox()
+{
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    if (!main_mailbox_)
+    {
+        main_mailbox_ = std::make_unique<ExternalMailbox>(*registry_.at(MAIN_THREAD_ID), MAIN_THREAD_ID);
+        main_mailbox_open_.store(true, std::memory_order_release);
+    }
+    return *main_mailbox_;
+}
+
+ExternalMailbox* ThreadWrapperApp::create_external_mailbox(const std::string& name, uint32_t capacity)
+{
+    ThreadWrapperParam params;
+    params.thread_instance_name = name;
+    params.queue_size = capacity;
+
+    std::lock_guard<std::mutex> lock(app_mutex_);
+    if (name.empty() || capacity == 0 || name_index_.find(name) != name_index_.end())
+    {
+        return nullptr;
+    }
+    // Like "main": a manager without a wrapper or thread, always accepting messages.
+    auto mgr = std::make_unique<ThreadWrapperMgr>(nullptr, params);
+    mgr->set_status(ThreadWrapperStatus::RUNNING);
+    const int id = registry_.add(std::move(mgr));
+    if (id == INVALID_INSTANCE_ID)
+    {
+        return nullptr;
+    }
+    bind_name(name, id);
+    external_mailboxes_.push_back(std::make_unique<ExternalMailbox>(*registry_.at(id), id));
+    return external_mailboxes_.back().get();
+}
+
+ThreadWrapperError ThreadWrapperApp::send_message_wait(int dest_id, int msg_id, std::shared_ptr<void> data)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+
+    return send_envelope_wait(dest_id, std::move(message), std::chrono::steady_clock::time_point::max());
+}
+
+ThreadWrapperError ThreadWrapperApp::send_message_for(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                                      std::chrono::steady_clock::duration timeout)
+{
+    ThreadWrapperMessage message;
+    message.msg_id = msg_id;
+    message.data = std::move(data);
+
+    return send_envelope_wait(dest_id, std::move(message), std::chrono::steady_clock::now() + timeout);
+}
+
+ThreadWrapperError ThreadWrapperApp::send_envelope_wait(int dest_id, ThreadWrapperMessage message,
+                                                        std::chrono::steady_clock::time_point deadline)
+{
+    ThreadWrapperMgr* mgr;
+    {
+        // Pin instead of holding the guard: we may block, and writers must not wait on us.
+        ThreadRegistry::ReadGuard guard(registry_);
+        mgr = resolve_dest(guard, dest_id);
+        if (!mgr) 
+        {
+            return ThreadWrapperError::ERROR_DEST_INVALID;
+        }
+        mgr->pin();
+    }
+
+    message.dest = dest_id;
+    ThreadWrapperError ret = mgr->push_message_to_queue_wait(std::move(message), deadline);
+    mgr->unpin();
+    return ret;
+}
+
+ThreadDetails ThreadWrapperApp::make_details(const ThreadWrapperMgr& mgr)
+{
+    ThreadDetails details;
+    details.name = mgr.get_thread_name();
+    details.status = mgr.get_status();
+    details.queue_size = mgr.get_queue_size();
+    details.cpu = mgr.get_current_cpu();
+    details.numa_node = mgr.get_current_numa_node();
+    details.cpu_affinity = mgr.get_cpu_affinity();
+    details.memory_node = mgr.get_memory_node();
+    details.metrics = mgr.get_metrics();
+    return details;
 }
 
 std::optional<ThreadDetails> ThreadWrapperApp::get_thread_details_by_name(const std::string& name) const {
     std::lock_guard<std::mutex> lock(app_mutex_);
-    for (const auto& mgr : thread_mgr_list_) {
-        if (mgr && mgr->get_thread_name() == name) {
-            ThreadDetails details;
-            details.name = mgr->get_thread_name();
-            details.status = mgr->get_status();
-            details.queue_size = mgr->get_queue_size();
-            return details;
+    auto it = name_index_.find(name);
+    if (it == name_index_.end()) {
+        return std::nullopt; // Thread not found
+    }
+    if (const ThreadWrapperMgr* mgr = registry_.at(it->second)) {
+        return make_details(*mgr);
+    }
+    const ReplicaGroup* group = registry_.group_at(it->second);
+    if (!group) {
+        return std::nullopt;
+    }
+
+    ThreadDetails details;
+    details.name = name;
+    details.status = ThreadWrapperStatus::RUNNING;
+    for (const ThreadWrapperMgr* replica : group->replicas()) {
+        ThreadDetails replica_details = make_details(*replica);
+        details.queue_size += replica_details.queue_size;
+        details.metrics.merge(replica_details.metrics);
+        if (details.status == ThreadWrapperStatus::RUNNING) {
+            details.status = replica_details.status;
         }
+        details.replicas.push_back(std::move(replica_details));
     }
-    return std::nullopt; // Thread not found
-}
\ No newline at end of file
+    return details;
+}
@@ -1,10 +1,21 @@
 #ifndef THREADWRAPPERAPP_HPP
 #define THREADWRAPPERAPP_HPP
 
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include "ThreadWrapper/BroadcastGroup.hpp"
+#include "ThreadWrapper/CompiledRoute.hpp"
+#include "ThreadWrapper/ExternalMailbox.hpp"
+#include "ThreadWrapper/RequestReply.hpp"
 #include "ThreadWrapper/ThreadDetails.hpp"
+#include "ThreadWrapper/ThreadRegistry.hpp"
 #include "ThreadWrapper/ThreadWrapperMgr.hpp"
+#include "ThreadWrapper/TimerWheel.hpp"
 
 class ThreadWrapperApp
 {
@@ -18,32 +29,325 @@ public:
 
     int create_thread_wrapper(std::unique_ptr<ThreadWrapper> thread_instance, const std::string& instance_name, int device_id, uint32_t msg_queue_size);
 
-    ThreadWrapperError start(std::vector<ThreadWrapperParam>& thread_param_list);
+    /**
+     * @brief Creates and starts the threads. A param with replicas > 1 becomes a
+     * replica group: its name and ID dispatch to replicas named "<name>#<i>".
+     *
+     * The threads initialize in parallel and are waited for together, for at
+     * most `init_timeout` in total (zero: no limit). If one fails or is late,
+     * the threads of this call, and only those, are stopped and unregistered;
+     * threads that have started are joined in the background, since some may
+     * still be inside initialize(), but their names are free again when start() returns.
+     * @return OK, ERROR, ERROR_DEST_INVALID, START_THREAD_FAILED or TIMEOUT.
+     */
+    ThreadWrapperError start(std::vector<ThreadWrapperParam>& thread_param_list,
+                             std::chrono::steady_clock::duration init_timeout =
+                                 std::chrono::steady_clock::duration::zero());
     
+    /// @brief Resolves a thread name to its ID through a hash index. O(1) on average.
     int get_thread_wrapper_id_by_name(const std::string& thread_name) const;
+
+    /**
+     * @brief Resolves a list of thread names into a CompiledRoute, once.
+     * Routes over the same names are shared, and follow a thread that is re-created
+     * under its old name. The returned route stays valid for the lifetime of the application.
+     * @return nullptr if any name is unknown.
+     */
+    const CompiledRoute* compile_route(const std::vector<std::string>& thread_names);
+
     ThreadWrapperError send_message(int dest_id, int msg_id, std::shared_ptr<void> data);
 
-    void stop();
-    void stop_threads(const std::vector<int>& thread_ids);
+    /// @brief Sends in the given lane; HIGH (control) messages overtake the destination's data backlog.
+    ThreadWrapperError send_message(int dest_id, int msg_id, std::shared_ptr<void> data, MessagePriority priority);
+
+    /**
+     * @brief Sends a typed payload.
+     * Small trivially copyable values are stored inline in the envelope (no
+     * allocation, no refcount); a shared_ptr<U> is passed through as a shared
+     * payload; anything else is moved into a new shared payload. The receiver
+     * reads it with ThreadWrapperMessage::payload_as<T>() in process_message(),
+     * which checks the type in debug builds.
+     */
+    template<typename T>
+    ThreadWrapperError send(int dest_id, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return send_envelope(dest_id, std::move(message));
+    }
+
+    /// @brief Typed counterpart of send_message_wait().
+    template<typename T>
+    ThreadWrapperError send_wait(int dest_id, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return send_envelope_wait(dest_id, std::move(message), std::chrono::steady_clock::time_point::max());
+    }
+
+    /// @brief Sends a fully built envelope without blocking. `message.dest` is set from `dest_id`.
+    ThreadWrapperError send_envelope(int dest_id, ThreadWrapperMessage message);
+
+    /**
+     * @brief Answers a request without blocking: the REPLY carries the request's
+     * correlation_id and goes to `request.reply_to`, which is a thread, a
+     * mailbox, or the future or callback of a send_request(). The payload is
+     * stored as for send().
+     * @return ERROR_DEST_INVALID if the request did not ask for a reply or its
+     * requester stopped waiting.
+     */
+    template<typename T>
+    ThreadWrapperError reply(const ThreadWrapperMessage& request, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return reply_envelope(request, std::move(message));
+    }
+
+    /// @brief Answers a request with a fully built envelope; see reply().
+    ThreadWrapperError reply_envelope(const ThreadWrapperMessage& request, ThreadWrapperMessage message);
+
+    /**
+     * @brief Tells the requester that `request` will never be answered. A future or
+     * callback completes with THREAD_ABNORMAL; a requesting thread or mailbox gets a
+     * REPLY with msg_id REQUEST_DROPPED_MSG_ID. Called for requests a stopping thread drops.
+     * @return As for reply_envelope().
+     */
+    ThreadWrapperError abandon_request(const ThreadWrapperMessage& request);
+
+    /**
+     * @brief Sends a request from any thread and returns a future for its reply.
+     * The destination answers with reply(); the reply is routed by correlation ID
+     * straight to the future, without passing through a mailbox. If the send
+     * fails the future is ready at once with that error.
+     */
+    template<typename T>
+    ReplyFuture send_request(int dest_id, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return send_request_envelope(dest_id, std::move(message));
+    }
+
+    /**
+     * @brief Same, but `callback` receives the reply, on the replying thread, so
+     * it must be short and must not block. On a send error the callback is not
+     * called.
+     * @param request_id If not null, receives the ID for cancel_request().
+     */
+    template<typename T>
+    ThreadWrapperError send_request(int dest_id, int msg_id, T&& value, ReplyCallback callback,
+                                    uint32_t* request_id = nullptr)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return send_request_envelope(dest_id, std::move(message), std::move(callback), request_id);
+    }
+
+    ReplyFuture send_request_envelope(int dest_id, ThreadWrapperMessage message);
+    ThreadWrapperError send_request_envelope(int dest_id, ThreadWrapperMessage message, ReplyCallback callback,
+                                             uint32_t* request_id = nullptr);
+
+    /// @brief Stops waiting for the reply to a callback request. @return false if it was answered already.
+    bool cancel_request(uint32_t request_id);
+
+    /**
+     * @brief The mailbox of the "main" entry (thread ID 0). Until the first call,
+     * sends to ID 0 fail with ERROR_DEST_INVALID as before; afterwards main
+     * receives like any thread and polls the mailbox for its messages.
+     */
+    ExternalMailbox& main_mailbox();
+
+    /**
+     * @brief Registers a mailbox for a thread the framework does not run, so
+     * workers can send (and reply) to that thread by name or ID.
+     * @return nullptr if the name is taken; otherwise a mailbox valid until stop().
+     */
+    ExternalMailbox* create_external_mailbox(const std::string& name, uint32_t capacity = 256);
+
+    /**
+     * @brief Calls `callback` once the destination's lane for `priority` has room
+     * again (or the destination exits), from the destination's worker. Lets a
+     * sender that got ENQUEUE_FAILED wait for capacity without blocking a thread.
+     * @return false if there is room already or `dest_id` is invalid; the callback is not kept.
+     */
+    bool notify_when_space(int dest_id, MessagePriority priority, std::function<void()> callback);
+
+    /// @brief Sends a fully built envelope, blocking while the destination is full, until `deadline`.
+    ThreadWrapperError send_envelope_wait(int dest_id, ThreadWrapperMessage message,
+                                          std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Sends one message to every destination in `dest_ids`, without blocking.
+     * All destinations are resolved under a single registry read and receive a
+     * copy of the same envelope, so the payload is shared (one refcount bump per
+     * destination, or a plain copy when it is inline) and never duplicated.
+     * Receivers must treat a shared payload as read-only. A destination that is
+     * invalid or full does not stop the others; it is listed in the result.
+     */
+    MulticastResult multicast(const std::vector<int>& dest_ids, int msg_id, std::shared_ptr<void> data);
+
+    /// @brief Typed counterpart of multicast(); the payload is built once, as for send().
+    template<typename T>
+    MulticastResult multicast_value(const std::vector<int>& dest_ids, int msg_id, T&& value)
+    {
+        ThreadWrapperMessage message;
+        message.msg_id = msg_id;
+        message.set_payload(std::forward<T>(value));
+        return multicast_envelope(dest_ids, std::move(message));
+    }
+
+    /// @brief Multicasts a fully built envelope; `dest` is set per destination.
+    MulticastResult multicast_envelope(const std::vector<int>& dest_ids, ThreadWrapperMessage message);
+
+    /**
+     * @brief Names a set of threads for broadcast(). Names are resolved now, and a
+     * member re-created under its old name is followed to its new ID.
+     * @return nullptr if a thread name is unknown or the group name is taken;
+     * otherwise a group that stays valid for the lifetime of the application.
+     */
+    const BroadcastGroup* create_broadcast_group(const std::string& group_name,
+                                                 const std::vector<std::string>& thread_names);
+    /// @brief Looks up a group created earlier. @return nullptr if there is none.
+    const BroadcastGroup* get_broadcast_group(const std::string& group_name) const;
+
+    /// @brief Multicasts to the members of `group`.
+    MulticastResult broadcast(const BroadcastGroup& group, int msg_id, std::shared_ptr<void> data);
+    /**
+     * @brief Same, by group name. An unknown group delivers nothing and reports a
+     * single (INVALID_INSTANCE_ID, ERROR_DEST_INVALID) failure.
+     */
+    MulticastResult broadcast(const std::string& group_name, int msg_id, std::shared_ptr<void> data);
+
+    /**
+     * @brief Sends a message, blocking while the destination queue is full.
+     * The sender is woken as soon as the destination frees a slot.
+     * @return OK, ERROR_DEST_INVALID, or THREAD_ABNORMAL if the destination exits while we wait.
+     */
+    ThreadWrapperError send_message_wait(int dest_id, int msg_id, std::shared_ptr<void> data);
+
+    /**
+     * @brief Like send_message_wait(), but gives up after `timeout`.
+     * @return ENQUEUE_FAILED if the queue is still full when the timeout expires.
+     */
+    ThreadWrapperError send_message_for(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                        std::chrono::steady_clock::duration timeout);
+
+    /**
+     * @brief Sends a message once `delay` has elapsed (1 ms resolution, never early).
+     * The timer runs on the application's timer wheel thread; a destination that is
+     * full at that moment is retried every tick.
+     * @return A handle for cancel_timer(); invalid if `dest_id` does not exist.
+     */
+    TimerHandle send_message_after(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                   std::chrono::steady_clock::duration delay);
+
+    /**
+     * @brief Sends a message every `period`, starting one period from now, until
+     * cancelled or the destination goes away. An occurrence the destination has
+     * no room for is skipped, and the schedule does not drift.
+     * @return A handle for cancel_timer(); invalid if `dest_id` does not exist.
+     */
+    TimerHandle schedule_periodic(int dest_id, int msg_id, std::shared_ptr<void> data,
+                                  std::chrono::steady_clock::duration period);
+
+    /// @brief Sends a fully built envelope once `delay` has elapsed; see send_message_after().
+    TimerHandle send_envelope_after(int dest_id, ThreadWrapperMessage message,
+                                    std::chrono::steady_clock::duration delay);
+
+    /// @brief Cancels a delayed or periodic message. @return false if it already fired or was cancelled.
+    bool cancel_timer(TimerHandle handle);
+
+    /// @brief Stops every thread; see stop_threads() for `mode`.
+    StopReport stop(StopMode mode = StopMode::abort_now());
+
+    /**
+     * @brief Stops and joins the given threads; a replica group ID, or the ID of any one replica, stops the whole group.
+     * Every thread is signalled before any is joined, so they wind down in
+     * parallel and the call lasts as long as the slowest one. A drain ends per
+     * thread when its own queue is empty: stop upstream stages first if what
+     * they still send must be processed downstream.
+     * @return Messages processed during the stop and discarded, summed over the threads.
+     */
+    StopReport stop_threads(const std::vector<int>& thread_ids, StopMode mode = StopMode::abort_now());
 
     std::optional<ThreadDetails> get_thread_details_by_name(const std::string& name) const;
 
 private:
     ThreadWrapperApp();
     
-    int create_thread_wrapper_mgr(std::unique_ptr<ThreadWrapper> thread_instance, const std::string& instance_name, int device_id, uint32_t msg_queue_size);
-    bool is_name_unique(const std::string& thread_name) const;
-    void release_threads();
+    int create_thread_wrapper_mgr(ThreadWrapperParam& params, std::vector<ThreadWrapperMgr*>& created);
+    static ThreadDetails make_details(const ThreadWrapperMgr& mgr);
+    StopReport release_threads(StopMode mode = StopMode::abort_now());
+    void collect_threads(const std::vector<int>& thread_ids, std::vector<ThreadWrapperMgr*>& mgrs,
+                         std::vector<int>& removed_ids);
+    void roll_back_in_background(const std::vector<int>& thread_ids);
+    void reap_rollbacks();
+    int replica_group_of(int id) const;
+    static StopReport stop_and_join(const std::vector<ThreadWrapperMgr*>& mgrs, StopMode mode);
+    void unregister(const std::vector<int>& ids);
+    void bind_name(const std::string& name, int id);
+    template <typename DestAt>
+    MulticastResult multicast_to(size_t count, DestAt dest_at, ThreadWrapperMessage message);
+    bool is_external_mailbox(int id) const;
+    ThreadWrapperMgr* resolve_dest(const ThreadRegistry::ReadGuard& guard, int dest_id) const noexcept;
+    TimerHandle add_timer(int dest_id, ThreadWrapperMessage message,
+                          std::chrono::steady_clock::duration delay,
+                          std::chrono::steady_clock::duration period);
+
+    // Shared worker pool for POOLED wrappers, created on first use. Declared
+    // before the registry so it outlives every manager that may be queued on it.
+    std::unique_ptr<Executor> executor_;
 
-    std::vector<std::unique_ptr<ThreadWrapperMgr>> thread_mgr_list_;
+    // Read lock-free by the send path. Writers (create, release) hold app_mutex_,
+    // which also guards the name index, routes and broadcast groups; it is never
+    // held while a thread initializes or joins.
+    ThreadRegistry registry_;
+    std::unordered_map<std::string, int> name_index_;
+    std::map<std::vector<std::string>, std::unique_ptr<CompiledRoute>> routes_; // Keyed by names, so restarts reuse them.
+    std::unordered_map<std::string, std::unique_ptr<BroadcastGroup>> broadcast_groups_;
+    std::vector<std::unique_ptr<ExternalMailbox>> external_mailboxes_; // Released with the threads.
+    // Failed start() batches being torn down in the background. Finished ones
+    // are joined by the next start(), the rest on release.
+    struct Rollback
+    {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Rollback> rollbacks_;
 
     mutable std::mutex app_mutex_;
 
+    // Delayed and periodic messages, started on first use and stopped before the threads.
+    std::unique_ptr<TimerWheel> timer_wheel_;
+
+    // Waiters of send_request(), and the main thread's mailbox once opened.
+    PendingReplies pending_replies_;
+    std::unique_ptr<ExternalMailbox> main_mailbox_;
+    std::atomic<bool> main_mailbox_open_{false};
+
     static constexpr int MAIN_THREAD_ID = 0;
 };
 
 ThreadWrapperApp& get_thread_wrapper_app_instance();
 ThreadWrapperError send_message(int dest, int msg_id, std::shared_ptr<void> data);
+ThreadWrapperError send_message(int dest, int msg_id, std::shared_ptr<void> data, MessagePriority priority);
+ThreadWrapperError send_message_wait(int dest, int msg_id, std::shared_ptr<void> data);
+ThreadWrapperError send_message_for(int dest, int msg_id, std::shared_ptr<void> data,
+                                    std::chrono::steady_clock::duration timeout);
+TimerHandle send_message_after(int dest, int msg_id, std::shared_ptr<void> data,
+                               std::chrono::steady_clock::duration delay);
+TimerHandle schedule_periodic(int dest, int msg_id, std::shared_ptr<void> data,
+                              std::chrono::steady_clock::duration period);
+bool cancel_timer(TimerHandle handle);
+MulticastResult multicast(const std::vector<int>& dest_ids, int msg_id, std::shared_ptr<void> data);
+MulticastResult broadcast(const std::string& group_name, int msg_id, std::shared_ptr<void> data);
 int get_thread_wrapper_id_by_name(const std::string& thread_name);
+const CompiledRoute* compile_route(const std::vector<std::string>& thread_names);
 
 #endif // THREADWRAPPERAPP_HPP
\ No newline at end of file
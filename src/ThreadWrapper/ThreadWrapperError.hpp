@@ -10,6 +10,7 @@ enum class ThreadWrapperError {
     ENQUEUE_FAILED = 5,
     START_THREAD_FAILED = 6,
     ERROR_DEST_INVALID = 7,
+    TIMEOUT = 8,
 };
 
 using TW = ThreadWrapperError;
@@ -1,10 +1,207 @@
 #ifndef THREADWRAPPERMESSAGE_HPP
 #define THREADWRAPPERMESSAGE_HPP
 
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <span>
+#include <typeinfo>
+#include <type_traits>
+
+// Payload type checks on receipt are on in debug builds; define the macro
+// explicitly to keep them in an NDEBUG build.
+#if !defined(NDEBUG) && !defined(THREAD_WRAPPER_CHECK_PAYLOAD_TYPES)
+#define THREAD_WRAPPER_CHECK_PAYLOAD_TYPES
+#endif
+
+enum class MessageKind : uint8_t {
+    DATA,   // Delivered to ThreadWrapper::process().
+    STOP,   // Poison pill: the worker exits once it dequeues this.
+    REPLY,  // Answer to a request, matched to its waiter by correlation_id.
+};
+
+/// @brief reply_to of a ThreadWrapperApp::send_request(): the reply completes a future or callback instead of being queued.
+static constexpr int REPLY_TO_PENDING = -2;
+
+/// @brief msg_id of the REPLY a requesting thread gets instead of an answer when its
+/// request was dropped unprocessed because the destination stopped.
+static constexpr int REQUEST_DROPPED_MSG_ID = -3;
+
+/**
+ * @enum MessagePriority
+ * @brief Mailbox lane a message travels in. HIGH messages are dequeued ahead
+ * of any NORMAL backlog and have capacity of their own.
+ */
+enum class MessagePriority : uint8_t {
+    NORMAL,
+    HIGH,
+};
+
+/**
+ * @struct PayloadTypeInfo
+ * @brief Per-type descriptor attached to typed payloads: the type for the
+ * debug check on receipt, and how to box an inline value into a
+ * shared_ptr for handlers that only implement process(int, shared_ptr<void>).
+ */
+struct PayloadTypeInfo {
+    const std::type_info* type;
+    std::shared_ptr<void> (*box)(const void* value);
+};
+
+template<typename T>
+std::shared_ptr<void> box_inline_payload(const void* value)
+{
+    if constexpr (std::is_copy_constructible<T>::value) {
+        return std::make_shared<T>(*static_cast<const T*>(value));
+    } else {
+        return nullptr; // Never stored inline.
+    }
+}
+
+template<typename T>
+inline const PayloadTypeInfo payload_type_info_v = {&typeid(T), &box_inline_payload<T>};
+
+template<typename T>
+struct is_shared_ptr : std::false_type {};
+
+template<typename T>
+struct is_shared_ptr<std::shared_ptr<T>> : std::true_type {};
+
+/**
+ * @struct ThreadWrapperMessage
+ * @brief The envelope queued in a mailbox. Stored by value, so a hop costs
+ * no allocation beyond whatever the payload itself owns.
+ *
+ * A payload is either shared (`data`, the original shared_ptr<void> path)
+ * or, for small trivially copyable types sent with ThreadWrapperApp::send<T>(),
+ * stored inline in the envelope with no allocation or refcount at all.
+ */
 struct ThreadWrapperMessage {
-    int dest;
-    int msg_id;
+    static constexpr size_t INLINE_PAYLOAD_CAPACITY = 24;
+
+    template<typename T>
+    static constexpr bool fits_inline_v =
+        std::is_trivially_copyable<T>::value &&
+        sizeof(T) <= INLINE_PAYLOAD_CAPACITY &&
+        alignof(T) <= 8;
+
+    int dest = 0;
+    int msg_id = 0;
+    MessageKind kind = MessageKind::DATA;
+    MessagePriority priority = MessagePriority::NORMAL;
+    bool has_inline_payload = false;
+    uint32_t enqueue_stamp = 0; // Sampled send time for queue-wait metrics; fills padding, 0 if not sampled.
+    uint32_t trace_id = 0;      // Non-zero while the message is part of a sampled trace (see Tracer).
+    uint16_t trace_hop = 0;     // Position of this message within its trace.
+    uint32_t correlation_id = 0; // Pairs a request with its REPLY; 0 when no reply is expected.
+    int reply_to = 0;            // Thread or mailbox ID a reply goes to, or REPLY_TO_PENDING.
+    const PayloadTypeInfo* payload_type = nullptr; // nullptr for untyped send_message() payloads
     std::shared_ptr<void> data = nullptr;
+    alignas(8) unsigned char inline_payload[INLINE_PAYLOAD_CAPACITY] = {};
+
+    /**
+     * @brief Stores a typed payload: inline if it fits, passed through if it is
+     * already a shared_ptr<U>, otherwise moved into a new shared payload.
+     */
+    template<typename T>
+    void set_payload(T&& value)
+    {
+        using U = std::decay_t<T>;
+        if constexpr (is_shared_ptr<U>::value) {
+            set_shared_payload(std::forward<T>(value));
+        } else if constexpr (fits_inline_v<U>) {
+            set_inline_payload<U>(value);
+        } else {
+            set_shared_payload(std::make_shared<U>(std::forward<T>(value)));
+        }
+    }
+
+    /// @brief Stores `value` inline. Only valid for types where fits_inline_v<T> holds.
+    template<typename T>
+    void set_inline_payload(const T& value)
+    {
+        static_assert(fits_inline_v<T>, "type is too large or not trivially copyable for an inline payload");
+        data.reset();
+        ::new (static_cast<void*>(inline_payload)) T(value);
+        has_inline_payload = true;
+        payload_type = &payload_type_info_v<T>;
+    }
+
+    /// @brief Stores a shared payload and remembers its type for the debug check.
+    template<typename T>
+    void set_shared_payload(std::shared_ptr<T> value)
+    {
+        data = std::move(value);
+        has_inline_payload = false;
+        payload_type = &payload_type_info_v<T>;
+    }
+
+    /**
+     * @brief Typed access to the payload, inline or shared.
+     * @return nullptr if there is no payload, or (with THREAD_WRAPPER_CHECK_PAYLOAD_TYPES)
+     *         if the payload was sent with a different type.
+     */
+    template<typename T>
+    T* payload_as()
+    {
+        if (!check_payload_type<T>()) {
+            return nullptr;
+        }
+        if (has_inline_payload) {
+            return std::launder(reinterpret_cast<T*>(inline_payload));
+        }
+        return static_cast<T*>(data.get());
+    }
+
+    /// @brief Typed access to a shared payload. Returns nullptr for inline payloads.
+    template<typename T>
+    std::shared_ptr<T> shared_payload_as() const
+    {
+        if (has_inline_payload || !check_payload_type<T>()) {
+            return nullptr;
+        }
+        return std::static_pointer_cast<T>(data);
+    }
+
+    /// @brief Moves the payload out as a shared_ptr, boxing an inline payload (one allocation).
+    std::shared_ptr<void> take_data()
+    {
+        if (has_inline_payload) {
+            has_inline_payload = false;
+            return payload_type->box(inline_payload);
+        }
+        return std::move(data);
+    }
+
+    void clear_payload() noexcept
+    {
+        data.reset();
+        has_inline_payload = false;
+        payload_type = nullptr;
+    }
+
+private:
+    template<typename T>
+    bool check_payload_type() const
+    {
+#ifdef THREAD_WRAPPER_CHECK_PAYLOAD_TYPES
+        if (payload_type != nullptr && *payload_type->type != typeid(T)) {
+            fprintf(stderr, "ThreadWrapperMessage: payload of msg %d is '%s', requested as '%s'\n",
+                    msg_id, payload_type->type->name(), typeid(T).name());
+            return false;
+        }
+#endif
+        return true;
+    }
 };
 
+/**
+ * @brief A non-owning view over a contiguous batch of messages, as passed to process_batch().
+ *
+ * Handlers may move payloads out of the messages; the storage is reused for the next batch.
+ */
+using MessageSpan = std::span<ThreadWrapperMessage>;
+
 #endif
\ No newline at end of file
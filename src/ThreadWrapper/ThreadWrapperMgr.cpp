@@ -1,30 +1,119 @@
 #include "ThreadWrapper/ThreadWrapperMgr.hpp"
+#include "ThreadWrapper/ThreadWrapperApp.hpp"
+#include "ThreadWrapper/CpuRelax.hpp"
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+
+namespace {
+std::vector<int> resolve_cpu_affinity(const ThreadWrapperParam& params)
+{
+    if (!params.cpu_affinity.empty() || params.numa_node < 0) {
+        return params.cpu_affinity;
+    }
+    return numa_node_cpus(params.numa_node);
+}
+
+int resolve_memory_node(const ThreadWrapperParam& params)
+{
+    if (params.numa_node >= 0) {
+        return params.numa_node;
+    }
+    return params.cpu_affinity.empty() ? -1 : numa_node_of_cpu(params.cpu_affinity.front());
+}
+
+MailboxType resolve_mailbox_type(const ThreadWrapperParam& params)
+{
+    // A busy-polling consumer must not take a lock per poll.
+    return params.busy_poll && params.execution_mode == ExecutionMode::DEDICATED
+        ? MailboxType::LOCK_FREE : params.mailbox_type;
+}
+}
 
 ThreadWrapperMgr::ThreadWrapperMgr(
     std::unique_ptr<ThreadWrapper> thread_instance,
-    const std::string& thread_name,
-    uint32_t msg_queue_size)
+    const ThreadWrapperParam& params)
+    : ThreadWrapperMgr(std::move(thread_instance), params, params.thread_instance_name)
+{
+}
+
+ThreadWrapperMgr::ThreadWrapperMgr(
+    std::unique_ptr<ThreadWrapper> thread_instance,
+    const ThreadWrapperParam& params,
+    const std::string& name,
+    Executor* executor)
     : thread_instance_(std::move(thread_instance)),
-      name_(thread_name),
-      msg_queue_(msg_queue_size),
+      name_(name),
+      cpu_affinity_(resolve_cpu_affinity(params)),
+      memory_node_(resolve_memory_node(params)),
+      msg_queue_(params.queue_size, resolve_mailbox_type(params), memory_node_,
+                 params.high_priority_capacity, params.high_priority_weight),
+      batch_size_(params.batch_size > 0 ? params.batch_size : 1),
+      busy_poll_(params.busy_poll && params.execution_mode == ExecutionMode::DEDICATED),
+      batch_buffer_(batch_size_, NumaAllocator<ThreadWrapperMessage>(memory_node_)),
+      init_future_(init_promise_.get_future()),
+      executor_(params.execution_mode == ExecutionMode::POOLED ? executor : nullptr),
       status_(ThreadWrapperStatus::READY)
 {
+    // A pooled wrapper must not be queued on the executor before start_thread(),
+    // even if a message or stop request reaches it first.
+    scheduled_.store(executor_ != nullptr, std::memory_order_relaxed);
+    if (!executor_) {
+        msg_queue_.set_wait_policy(params.wait_policy, std::chrono::microseconds(params.max_spin_us));
+    }
+    if (params.fd_events && !executor_ && !busy_poll_) {
+        event_loop_ = std::make_unique<FdEventLoop>();
+        int wake_fd = msg_queue_.enable_wake_fd();
+        if (!event_loop_->valid() || wake_fd < 0 || event_loop_->set_wake_fd(wake_fd) != ThreadWrapperError::OK) {
+            printf("警告: 线程 '%s' 无法创建 epoll/eventfd，fd 事件不可用。\n", name_.c_str());
+            event_loop_.reset();
+        }
+    } else if (params.fd_events) {
+        printf("警告: 线程 '%s' 为池化或忙轮询模式，忽略 fd 事件。\n", name_.c_str());
+    }
+    if (thread_instance_) {
+        thread_instance_->attach_event_loop(event_loop_.get());
+        if (executor_) {
+            thread_instance_->hold_emits_when_full(); // A blocked emit() would hold a shared worker.
+        }
+    }
+    if (params.busy_poll && executor_) {
+        printf("警告: 线程 '%s' 为池化模式，忽略忙轮询。\n", name_.c_str());
+    } else if (busy_poll_ && params.mailbox_type != MailboxType::LOCK_FREE) {
+        printf("警告: 线程 '%s' 为忙轮询模式，改用无锁邮箱。\n", name_.c_str());
+    }
 }
 
 ThreadWrapperMgr::~ThreadWrapperMgr()
 {
-    if (thread_.joinable()) {
-        join_thread();
-    }
+    join_thread();
 }
 
 void ThreadWrapperMgr::start_thread()
 {
+    started_ = true;
+    if (executor_) {
+        if (!cpu_affinity_.empty()) {
+            printf("警告: 线程 '%s' 为池化模式，忽略 CPU 绑定。\n", name_.c_str());
+        }
+        scheduled_.store(true, std::memory_order_seq_cst);
+        submit_to_executor(false);
+        return;
+    }
     thread_ = std::thread([this]() { this->thread_entry(); });
 }
 
 void ThreadWrapperMgr::join_thread()
 {
+    if (executor_) {
+        if (started_) {
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_cv_.wait(lock, [this]() { return done_; });
+        }
+        return;
+    }
+    // Overlapping stop_threads() calls may both join.
+    std::lock_guard<std::mutex> lock(join_mutex_);
     if (thread_.joinable()) {
         thread_.join();
     }
@@ -32,64 +121,495 @@ void ThreadWrapperMgr::join_thread()
 
 // 采用“毒丸”模式，修复死锁问题
 void ThreadWrapperMgr::thread_entry()
+{
+    Tracer::set_thread_name(name_);
+    apply_placement();
+    if (!initialize_instance()) {
+        return;
+    }
+    last_batch_end_ns_ = ThreadMetrics::now_ns();
+
+    if (busy_poll_) {
+        poll_loop();
+    } else if (event_loop_) {
+        fd_loop();
+    } else {
+        bool running = true;
+        while (running) {
+            uint32_t popped = msg_queue_.wait_and_pop_batch(batch_buffer_.data(), batch_size_);
+            sample_cpu();
+            running = handle_batch(popped);
+        }
+    }
+    finish();
+}
+
+void ThreadWrapperMgr::poll_loop()
+{
+    // Never parks, so the consumer never announces sleep and senders never notify.
+    while (true) {
+        uint32_t popped = msg_queue_.try_pop_batch(batch_buffer_.data(), batch_size_);
+        if (popped == 0) {
+            if (thread_instance_->on_idle() != ThreadWrapperError::OK) {
+                set_status(ThreadWrapperStatus::ERROR);
+                return;
+            }
+            cpu_relax();
+            continue;
+        }
+        sample_cpu();
+        if (!handle_batch(popped)) {
+            return;
+        }
+    }
+}
+
+void ThreadWrapperMgr::fd_loop()
+{
+    FdEventLoop::Ready ready[FdEventLoop::MAX_READY];
+    while (true) {
+        uint32_t popped = msg_queue_.try_pop_batch(batch_buffer_.data(), batch_size_);
+        if (popped > 0) {
+            sample_cpu();
+            if (!handle_batch(popped)) {
+                return;
+            }
+        }
+
+        int count = 0;
+        if (popped == 0) {
+            // Nothing queued: block until a message or a watched descriptor wakes us.
+            if (msg_queue_.begin_fd_wait()) {
+                count = event_loop_->wait(ready, -1);
+                msg_queue_.end_fd_wait();
+            }
+        } else if (event_loop_->watch_count() > 0) {
+            // Keep serving the descriptors while messages keep coming.
+            count = event_loop_->wait(ready, 0);
+        }
+        if (!dispatch_fd_events(ready, count)) {
+            return;
+        }
+    }
+}
+
+bool ThreadWrapperMgr::dispatch_fd_events(const FdEventLoop::Ready* ready, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        // A callback earlier in this round may have unwatched (and closed) the descriptor.
+        if (ready[i].readable && event_loop_->watching(ready[i].fd) &&
+            thread_instance_->on_readable(ready[i].fd) != ThreadWrapperError::OK) {
+            set_status(ThreadWrapperStatus::ERROR);
+            return false;
+        }
+        if (ready[i].writable && event_loop_->watching(ready[i].fd) &&
+            thread_instance_->on_writable(ready[i].fd) != ThreadWrapperError::OK) {
+            set_status(ThreadWrapperStatus::ERROR);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ThreadWrapperMgr::run_slice()
+{
+    process_slice();
+    // The pin taken when this slice was submitted. Once the worker lets go, a
+    // finished manager may be destroyed, so this is the slice's last access.
+    unpin();
+}
+
+void ThreadWrapperMgr::process_slice()
+{
+    // Bounds how long one pooled wrapper keeps a worker before letting others run.
+    static constexpr uint32_t BATCHES_PER_SLICE = 4;
+
+    if (!initialized_) {
+        initialized_ = true;
+        if (!initialize_instance()) {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_ = true;
+            done_cv_.notify_all();
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < BATCHES_PER_SLICE; ++i) {
+        if (wait_for_held_emits()) {
+            return;
+        }
+        uint32_t popped = msg_queue_.try_pop_batch(batch_buffer_.data(), batch_size_);
+        if (popped == 0) {
+            break;
+        }
+        sample_cpu();
+        if (!handle_batch(popped)) {
+            finish(); // scheduled_ stays set: the wrapper is never queued again.
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_ = true;
+            done_cv_.notify_all();
+            return;
+        }
+    }
+    if (wait_for_held_emits()) {
+        return;
+    }
+
+    scheduled_.store(false, std::memory_order_seq_cst);
+    // Pairs with the fence in schedule(): either we see the message pushed
+    // while we were running, or its sender sees scheduled_ cleared.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!msg_queue_.empty() && !scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        submit_to_executor(true);
+    }
+}
+
+bool ThreadWrapperMgr::wait_for_held_emits()
+{
+    int dest_id = INVALID_INSTANCE_ID;
+    MessagePriority priority = MessagePriority::NORMAL;
+    while (!thread_instance_->flush_held_emits(dest_id, priority)) {
+        // The target is still full: take no more messages, and come back when it
+        // has room. scheduled_ stays set, so senders do not queue us meanwhile;
+        // the pin is the one submit_to_executor() would take for that slice.
+        pin();
+        if (ThreadWrapperApp::get_instance().notify_when_space(dest_id, priority,
+                                                               [this]() { executor_->submit(this, true); })) {
+            return true;
+        }
+        unpin(); // Room already, or the target is gone: retry now.
+    }
+    return false;
+}
+
+void ThreadWrapperMgr::schedule()
+{
+    if (!executor_) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!scheduled_.load(std::memory_order_relaxed) && !scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        submit_to_executor(false);
+    }
+}
+
+void ThreadWrapperMgr::submit_to_executor(bool yielded)
+{
+    // Held until run_slice() returns: a stop may finish the wrapper on another
+    // worker while this one is still leaving its slice, and the registry only
+    // destroys a manager once nobody holds a pin.
+    pin();
+    executor_->submit(this, yielded);
+}
+
+void ThreadWrapperMgr::apply_placement()
+{
+    if (!cpu_affinity_.empty()) {
+        int err = pin_current_thread(cpu_affinity_);
+        if (err != 0) {
+            printf("警告: 线程 '%s' 绑定 CPU 失败 (%s)，使用默认亲和性。\n", name_.c_str(), strerror(err));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(placement_mutex_);
+        actual_affinity_ = current_thread_affinity();
+    }
+    sample_cpu();
+}
+
+void ThreadWrapperMgr::sample_cpu()
+{
+    // sched_getcpu() is a vDSO/rseq read; the node lookup is a syscall, so only redo it on migration.
+    int cpu = sched_getcpu();
+    if (cpu != current_cpu_.load(std::memory_order_relaxed)) {
+        int node = -1;
+        current_cpu_and_node(cpu, node);
+        current_node_.store(node, std::memory_order_relaxed);
+        current_cpu_.store(cpu, std::memory_order_relaxed);
+    }
+}
+
+std::vector<int> ThreadWrapperMgr::get_cpu_affinity() const
+{
+    std::lock_guard<std::mutex> lock(placement_mutex_);
+    return actual_affinity_;
+}
+
+bool ThreadWrapperMgr::initialize_instance()
 {
     if (!thread_instance_) {
+        discard_backlog();
         init_promise_.set_value(false);
-        return;
+        return false;
     }
 
     if (thread_instance_->initialize() != ThreadWrapperError::OK) {
         set_status(ThreadWrapperStatus::ERROR);
+        discard_backlog(); // Requests sent before or during initialize() must not wait forever.
         init_promise_.set_value(false);
-        return;
+        return false;
     }
 
     set_status(ThreadWrapperStatus::RUNNING);
     init_promise_.set_value(true);
+    return true;
+}
 
-    while (true) {
-        std::shared_ptr<ThreadWrapperMessage> msg;
-        msg_queue_.wait_and_pop(msg);
+bool ThreadWrapperMgr::handle_batch(uint32_t popped)
+{
+    // Two clock reads per batch, shared by the blocked, busy and queue-wait figures.
+    const uint64_t start_ns = ThreadMetrics::now_ns();
+    if (!executor_) {
+        metrics_.record_blocked(start_ns - last_batch_end_ns_);
+    }
+    metrics_.record_queue_depth(popped + msg_queue_.size());
 
-        if (!msg) {
-            break; 
+    bool running = true;
+    size_t count = 0;
+    size_t sampled = 0; // Queue-wait samples and traced messages, timed one by one.
+    while (count < popped) {
+        const ThreadWrapperMessage& message = batch_buffer_[count];
+        if (message.kind == MessageKind::STOP) {
+            running = false; // Poison pill: finish what came before it, drop the rest.
+            break;
         }
+        if (message.enqueue_stamp != 0) {
+            metrics_.record_queue_wait(ThreadMetrics::stamp_age_ns(message.enqueue_stamp, start_ns));
+            ++sampled;
+        }
+        if (message.trace_id != 0) {
+            Tracer::record(TraceEventType::DEQUEUE, TraceTag::of(message), start_ns);
+            ++sampled;
+        }
+        ++count;
+    }
+    for (size_t i = count; i < popped; ++i) {
+        drop_unprocessed(batch_buffer_[i]);
+    }
 
-        if (thread_instance_->process(msg->msg_id, msg->data) != ThreadWrapperError::OK) {
+    if (count > 0) {
+        ThreadWrapperError ret = sampled == 0
+            ? thread_instance_->process_batch(MessageSpan(batch_buffer_.data(), count))
+            : process_sampled_batch(count);
+        if (ret != ThreadWrapperError::OK) {
             set_status(ThreadWrapperStatus::ERROR);
+            running = false;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        batch_buffer_[i].clear_payload();
+    }
+
+    const uint64_t end_ns = ThreadMetrics::now_ns();
+    metrics_.record_batch(static_cast<uint32_t>(count), end_ns - start_ns);
+    last_batch_end_ns_ = end_ns;
+    return running;
+}
+
+ThreadWrapperError ThreadWrapperMgr::process_sampled_batch(size_t count)
+{
+    // Sampled and traced messages are handed over one at a time, so their
+    // processing time and whatever they send can be attributed to them; the
+    // rest stay batched. Sampling follows the 1-in-64 queue-wait stamps.
+    size_t run_begin = 0;
+    for (size_t i = 0; i <= count; ++i) {
+        if (i < count && batch_buffer_[i].trace_id == 0 && batch_buffer_[i].enqueue_stamp == 0) {
+            continue;
+        }
+        if (i > run_begin) {
+            ThreadWrapperError ret = thread_instance_->process_batch(
+                MessageSpan(batch_buffer_.data() + run_begin, i - run_begin));
+            if (ret != ThreadWrapperError::OK) {
+                return ret;
+            }
+        }
+        if (i == count) {
             break;
         }
+
+        // Taken before the call: the handler may move the envelope out.
+        const TraceTag trace = TraceTag::of(batch_buffer_[i]);
+        const uint64_t begin_ns = ThreadMetrics::now_ns();
+        ThreadWrapperError ret;
+        {
+            Tracer::Scope scope(trace);
+            ret = thread_instance_->process_batch(MessageSpan(batch_buffer_.data() + i, 1));
+        }
+        const uint64_t process_ns = ThreadMetrics::now_ns() - begin_ns;
+        metrics_.record_process_time(process_ns);
+        if (trace.trace_id != 0) {
+            Tracer::record(TraceEventType::PROCESS, trace, begin_ns, process_ns);
+        }
+        if (ret != ThreadWrapperError::OK) {
+            return ret;
+        }
+        run_begin = i + 1;
     }
+    return ThreadWrapperError::OK;
+}
 
+void ThreadWrapperMgr::finish()
+{
+    thread_instance_->on_stop();
     set_status(ThreadWrapperStatus::EXITED);
+    discard_backlog();
+}
+
+void ThreadWrapperMgr::discard_backlog()
+{
+    // Nobody will drain the queue any more; release senders blocked on it, and
+    // drop the backlog now rather than when the manager is destroyed.
+    msg_queue_.close();
+    std::lock_guard<std::mutex> lock(discard_mutex_);
+    discarded_.fetch_add(msg_queue_.clear(drop_unprocessed), std::memory_order_relaxed);
+    backlog_discarded_ = true;
 }
 
+void ThreadWrapperMgr::drop_late_arrival()
+{
+    // The push raced with discard_backlog(). If the final clear() has already
+    // run, nobody else will look at the item, so drop it here; otherwise that
+    // clear() is still to come and will find it.
+    std::lock_guard<std::mutex> lock(discard_mutex_);
+    if (backlog_discarded_) {
+        discarded_.fetch_add(msg_queue_.clear(drop_unprocessed), std::memory_order_relaxed);
+    }
+}
 
-ThreadWrapperError ThreadWrapperMgr::wait_for_init()
+void ThreadWrapperMgr::drop_unprocessed(ThreadWrapperMessage& message)
 {
-    auto init_future = init_promise_.get_future();
-    if (init_future.get()) {
+    // A dropped request still owes its requester an answer, or the waiter hangs.
+    if (message.correlation_id != 0) {
+        ThreadWrapperApp::get_instance().abandon_request(message);
+    }
+    message.clear_payload();
+}
+
+
+ThreadWrapperError ThreadWrapperMgr::wait_for_init(std::chrono::steady_clock::time_point deadline)
+{
+    if (deadline != std::chrono::steady_clock::time_point::max() &&
+        init_future_.wait_until(deadline) == std::future_status::timeout) {
+        return ThreadWrapperError::TIMEOUT;
+    }
+    if (init_future_.get()) {
         return ThreadWrapperError::OK;
     }
     return ThreadWrapperError::START_THREAD_FAILED;
 }
 
-ThreadWrapperError ThreadWrapperMgr::push_message_to_queue(std::shared_ptr<ThreadWrapperMessage> message)
+bool ThreadWrapperMgr::notify_when_space(MessagePriority priority, std::function<void()> callback)
+{
+    if (status_ == ThreadWrapperStatus::EXITED || status_ == ThreadWrapperStatus::ERROR) {
+        return false;
+    }
+    return msg_queue_.notify_when_space(priority, std::move(callback));
+}
+
+ThreadWrapperError ThreadWrapperMgr::push_message_to_queue(ThreadWrapperMessage message)
 {
     if (status_ == ThreadWrapperStatus::EXITED || status_ == ThreadWrapperStatus::ERROR) 
     {
-       if (message != nullptr) 
-       {
-            return ThreadWrapperError::THREAD_ABNORMAL;
-       }
+        return ThreadWrapperError::THREAD_ABNORMAL;
     }
+    stamp_for_queue_wait(message);
+    TraceTag trace;
+    const uint64_t trace_ns = Tracer::on_send(message, trace) ? ThreadMetrics::now_ns() : 0;
     if (!msg_queue_.push(std::move(message))) 
     {
+        if (msg_queue_.closed())
+        {
+            return ThreadWrapperError::THREAD_ABNORMAL;
+        }
+        metrics_.add_enqueue_failure();
         return ThreadWrapperError::ENQUEUE_FAILED;
     }
+    if (msg_queue_.closed())
+    {
+        drop_late_arrival();
+        return ThreadWrapperError::OK; // Accepted, then dropped like the rest of the backlog.
+    }
+    if (trace_ns != 0) {
+        Tracer::record(TraceEventType::ENQUEUE, trace, trace_ns);
+    }
+    schedule();
+    return ThreadWrapperError::OK;
+}
+
+bool ThreadWrapperMgr::receive_message(ThreadWrapperMessage& message, std::chrono::steady_clock::time_point deadline)
+{
+    if (!msg_queue_.wait_and_pop_until(message, deadline)) 
+    {
+        return false;
+    }
+    metrics_.record_received();
+    return true;
+}
+
+ThreadWrapperError ThreadWrapperMgr::push_stop_message(StopMode mode)
+{
+    uint64_t expected = NOT_STOPPING;
+    processed_at_stop_.compare_exchange_strong(expected, metrics_.messages_processed(), std::memory_order_relaxed);
+    // Not queued behind the backlog and needs no free slot, so it cannot fail.
+    msg_queue_.request_stop(mode.kind != StopMode::Kind::ABORT_NOW, mode.deadline);
+    schedule();
     return ThreadWrapperError::OK;
 }
 
+StopReport ThreadWrapperMgr::get_stop_report() const
+{
+    StopReport report;
+    const uint64_t base = processed_at_stop_.load(std::memory_order_relaxed);
+    if (base != NOT_STOPPING) {
+        report.processed = metrics_.messages_processed() - base;
+    }
+    report.discarded = discarded_.load(std::memory_order_relaxed);
+    return report;
+}
+
+ThreadWrapperError ThreadWrapperMgr::push_message_to_queue_wait(
+    ThreadWrapperMessage message,
+    std::chrono::steady_clock::time_point deadline)
+{
+    if (status_ == ThreadWrapperStatus::EXITED || status_ == ThreadWrapperStatus::ERROR)
+    {
+        return ThreadWrapperError::THREAD_ABNORMAL;
+    }
+    stamp_for_queue_wait(message);
+    TraceTag trace;
+    const uint64_t trace_ns = Tracer::on_send(message, trace) ? ThreadMetrics::now_ns() : 0;
+    if (!msg_queue_.push_wait(std::move(message), deadline))
+    {
+        if (status_ == ThreadWrapperStatus::EXITED || status_ == ThreadWrapperStatus::ERROR)
+        {
+            return ThreadWrapperError::THREAD_ABNORMAL;
+        }
+        metrics_.add_enqueue_failure();
+        return ThreadWrapperError::ENQUEUE_FAILED;
+    }
+    if (msg_queue_.closed())
+    {
+        drop_late_arrival();
+        return ThreadWrapperError::OK;
+    }
+    if (trace_ns != 0) {
+        Tracer::record(TraceEventType::ENQUEUE, trace, trace_ns);
+    }
+    schedule();
+    return ThreadWrapperError::OK;
+}
+
+void ThreadWrapperMgr::stamp_for_queue_wait(ThreadWrapperMessage& message) noexcept
+{
+    // Per sending thread, so sampling costs no shared write; a clock read on one send in 64.
+    thread_local uint32_t sends = 0;
+    if (sends++ % ThreadMetrics::QUEUE_WAIT_SAMPLE_PERIOD == 0) {
+        message.enqueue_stamp = ThreadMetrics::make_stamp(ThreadMetrics::now_ns());
+    } else {
+        message.enqueue_stamp = 0;
+    }
+}
+
 uint32_t ThreadWrapperMgr::get_queue_size() const {
     return msg_queue_.size();
 }
\ No newline at end of file
@@ -6,10 +6,21 @@
 #include <string>
 #include <future>
 #include <atomic>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
-#include "ThreadWrapper/ThreadSafeQueue.hpp"
+#include "ThreadWrapper/Executor.hpp"
+#include "ThreadWrapper/FdEventLoop.hpp"
+#include "ThreadWrapper/Mailbox.hpp"
+#include "ThreadWrapper/Placement.hpp"
+#include "ThreadWrapper/ThreadMetrics.hpp"
 #include "ThreadWrapper/ThreadWrapper.hpp"
 #include "ThreadWrapper/ThreadWrapperMessage.hpp"
+#include "ThreadWrapper/Tracer.hpp"
 
 enum class ThreadWrapperStatus {
     READY,
@@ -19,38 +30,193 @@ enum class ThreadWrapperStatus {
     ERROR
 };
 
+/**
+ * @struct StopMode
+ * @brief What a stopping thread does with the messages still queued for it.
+ *
+ * A drain ends when the queue is found empty, so messages that keep arriving
+ * meanwhile are processed too; the deadline is checked between batches, so a
+ * handler that is running when it passes is not interrupted.
+ */
+struct StopMode {
+    enum class Kind {
+        ABORT_NOW,   // Exit ahead of the backlog, which is discarded.
+        DRAIN,       // Process the backlog, then exit.
+        DRAIN_UNTIL  // Process the backlog, but discard what is left at the deadline.
+    };
+
+    Kind kind = Kind::ABORT_NOW;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    static StopMode abort_now() { return {}; }
+    static StopMode drain() { return {Kind::DRAIN, std::chrono::steady_clock::time_point::max()}; }
+    static StopMode drain_until(std::chrono::steady_clock::time_point deadline) { return {Kind::DRAIN_UNTIL, deadline}; }
+    static StopMode drain_for(std::chrono::steady_clock::duration timeout)
+    {
+        return drain_until(std::chrono::steady_clock::now() + timeout);
+    }
+};
+
+/// @brief What a stop did with the backlog, summed over the threads it stopped.
+struct StopReport {
+    uint64_t processed = 0; // Messages handled after the stop was requested.
+    uint64_t discarded = 0; // Messages still queued when the thread exited, dropped unprocessed.
+
+    StopReport& operator+=(const StopReport& other) noexcept
+    {
+        processed += other.processed;
+        discarded += other.discarded;
+        return *this;
+    }
+};
+
 class ThreadWrapperMgr
 {
 public:
-    ThreadWrapperMgr(std::unique_ptr<ThreadWrapper> thread_instance, const std::string& thread_name, uint32_t msg_queue_size);
+    ThreadWrapperMgr(std::unique_ptr<ThreadWrapper> thread_instance, const ThreadWrapperParam& params);
+    /**
+     * @brief Same, but registered under `name` instead of params.thread_instance_name (used for replicas).
+     * @param executor Runs the wrapper when params.execution_mode is POOLED; ignored otherwise.
+     */
+    ThreadWrapperMgr(std::unique_ptr<ThreadWrapper> thread_instance, const ThreadWrapperParam& params,
+                     const std::string& name, Executor* executor = nullptr);
     ~ThreadWrapperMgr();
 
     ThreadWrapperMgr(const ThreadWrapperMgr&) = delete;
     ThreadWrapperMgr& operator=(const ThreadWrapperMgr&) = delete;
 
+    /// @brief Starts the worker thread, or for a pooled wrapper schedules its initialize() on the executor.
     void start_thread();
+    /// @brief Waits until the wrapper has exited (thread joined, or pooled run finished). Any thread may call it.
     void join_thread();
 
+    /// @brief Resolves the wrapper's declared outputs; must run before start_thread().
+    ThreadWrapperError bind_outputs(const std::function<int(const std::string&)>& resolve_id)
+    {
+        return thread_instance_ ? thread_instance_->bind_outputs(resolve_id) : ThreadWrapperError::OK;
+    }
+
+    /// @brief Executor entry point: initializes on first run, then processes a few batches.
+    void run_slice();
+
     const std::string& get_thread_name() const noexcept { return name_; }
     ThreadWrapperStatus get_status() const noexcept { return status_; }
     void set_status(ThreadWrapperStatus status) noexcept { status_ = status; }
     
-    ThreadWrapperError push_message_to_queue(std::shared_ptr<ThreadWrapperMessage> message);
-    ThreadWrapperError wait_for_init();
+    ThreadWrapperError push_message_to_queue(ThreadWrapperMessage message);
+    ThreadWrapperError push_message_to_queue_wait(ThreadWrapperMessage message,
+                                                  std::chrono::steady_clock::time_point deadline);
+    /// @brief See Mailbox::notify_when_space(). @return false if there is room already or the wrapper has exited.
+    bool notify_when_space(MessagePriority priority, std::function<void()> callback);
+    /// @brief Makes the worker exit, ahead of the queued messages or after them as `mode` says. Always succeeds.
+    ThreadWrapperError push_stop_message(StopMode mode = StopMode::abort_now());
+    /// @brief Backlog processed and discarded since push_stop_message(); complete once join_thread() returned.
+    StopReport get_stop_report() const;
+    /**
+     * @brief Waits until initialize() has returned, or until `deadline`. Call at most once.
+     * @return OK, START_THREAD_FAILED, or TIMEOUT if initialize() is still running at the deadline.
+     */
+    ThreadWrapperError wait_for_init(std::chrono::steady_clock::time_point deadline =
+                                         std::chrono::steady_clock::time_point::max());
+
+    /**
+     * @brief Consumer side of a manager without a worker (the "main" entry and
+     * external mailboxes): dequeues one message, waiting until `deadline`
+     * (time_point::min() polls). Only one thread may receive at a time.
+     * @return false if nothing arrived in time.
+     */
+    bool receive_message(ThreadWrapperMessage& message, std::chrono::steady_clock::time_point deadline);
 
     uint32_t get_queue_size() const;
+    /// @brief Lock-free estimate of get_queue_size(), for per-message load balancing.
+    uint32_t approx_queue_size() const noexcept { return msg_queue_.approx_size(); }
+
+    /// @brief CPU and NUMA node the wrapper last ran on (-1 until it has run).
+    int get_current_cpu() const noexcept { return current_cpu_.load(std::memory_order_relaxed); }
+    int get_current_numa_node() const noexcept { return current_node_.load(std::memory_order_relaxed); }
+    /// @brief Affinity mask the worker thread actually has (empty until it started).
+    std::vector<int> get_cpu_affinity() const;
+    /// @brief NUMA node the mailbox was allocated on, -1 if left to the OS.
+    int get_memory_node() const noexcept { return memory_node_; }
+
+    /// @brief Throughput, backlog and latency counters; safe to call from any thread.
+    ThreadMetricsSnapshot get_metrics() const { return metrics_.snapshot(); }
+
+    /**
+     * @brief Keeps this manager alive across a blocking send made outside a registry ReadGuard.
+     * Take the pin inside the guard; ThreadRegistry waits for it before destroying the manager.
+     */
+    void pin() noexcept { pin_count_.fetch_add(1, std::memory_order_acq_rel); }
+    void unpin() noexcept { pin_count_.fetch_sub(1, std::memory_order_acq_rel); }
+    bool is_pinned() const noexcept { return pin_count_.load(std::memory_order_acquire) != 0; }
 
 private:
     void thread_entry();
+    void poll_loop();
+    void fd_loop();
+    bool dispatch_fd_events(const FdEventLoop::Ready* ready, int count);
+
+    // Loop steps shared by the dedicated thread and the executor.
+    bool initialize_instance();
+    bool handle_batch(uint32_t popped);
+    ThreadWrapperError process_sampled_batch(size_t count);
+    void finish();
+    void discard_backlog();
+    void drop_late_arrival();
+    static void drop_unprocessed(ThreadWrapperMessage& message);
+
+    void process_slice();
+    bool wait_for_held_emits();
+    void schedule();
+    void submit_to_executor(bool yielded);
+    void apply_placement();
+    void sample_cpu();
+    static void stamp_for_queue_wait(ThreadWrapperMessage& message) noexcept;
 
     std::unique_ptr<ThreadWrapper> thread_instance_;
     std::string name_;
-    ThreadSafeQueue<std::shared_ptr<ThreadWrapperMessage>> msg_queue_;
+    std::vector<int> cpu_affinity_;
+    int memory_node_;
+    Mailbox msg_queue_;
+    uint32_t batch_size_;
+    const bool busy_poll_;
+    std::unique_ptr<FdEventLoop> event_loop_; // Set when the worker waits in epoll (fd_events).
+    std::vector<ThreadWrapperMessage, NumaAllocator<ThreadWrapperMessage>> batch_buffer_;
 
     std::thread thread_;
+    std::mutex join_mutex_;
     std::promise<bool> init_promise_;
+    std::future<bool> init_future_;
+
+    // Pooled mode. scheduled_ is true from the moment the wrapper is queued on
+    // the executor until its slice ends, so at most one worker runs it.
+    Executor* executor_;
+    std::atomic<bool> scheduled_{false};
+    bool started_ = false;
+    bool initialized_ = false;
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    bool done_ = false;
 
     std::atomic<ThreadWrapperStatus> status_;
+    std::atomic<int> pin_count_{0};
+
+    std::atomic<int> current_cpu_{-1};
+    std::atomic<int> current_node_{-1};
+    mutable std::mutex placement_mutex_;
+    std::vector<int> actual_affinity_;
+
+    ThreadMetrics metrics_;
+    uint64_t last_batch_end_ns_ = 0; // Consumer only; start of the current blocked period.
+
+    // Stop accounting: the processed count when the first stop request came
+    // in, and the messages dropped once the mailbox closed. discard_mutex_
+    // serialises the final clear() with senders that raced past close().
+    static constexpr uint64_t NOT_STOPPING = UINT64_MAX;
+    std::atomic<uint64_t> processed_at_stop_{NOT_STOPPING};
+    std::atomic<uint64_t> discarded_{0};
+    std::mutex discard_mutex_;
+    bool backlog_discarded_ = false; // Guarded by discard_mutex_.
 };
 
 #endif // THREADWRAPPERMGR_HPP
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "ThreadWrapper/TimerWheel.hpp"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(DeliverFn deliver)
+    : deliver_(std::move(deliver)),
+      start_(Clock::now())
+{
+    std::fill(std::begin(heads_), std::end(heads_), NIL);
+    thread_ = std::thread(&TimerWheel::run, this);
+}
+
+TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t TimerWheel::now_tick() const
+{
+    return static_cast<uint64_t>((Clock::now() - start_) / TICK);
+}
+
+uint64_t TimerWheel::to_ticks(Clock::duration duration) const
+{
+    if (duration <= Clock::duration::zero()) {
+        return 0;
+    }
+    return static_cast<uint64_t>((duration + TICK - Clock::duration(1)) / TICK);
+}
+
+TimerHandle TimerWheel::add(int dest_id, ThreadWrapperMessage message, Clock::duration delay,
+                            Clock::duration period)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t now = now_tick();
+    if (live_ == 0) {
+        // Nothing is linked, so skip the idle ticks instead of replaying them.
+        current_tick_ = std::max(current_tick_, now);
+    }
+
+    uint32_t index = allocate_node();
+    Node& node = nodes_[index];
+    node.message = std::move(message);
+    node.dest_id = dest_id;
+    // The current tick may be partly over: fire one tick later so the delay is never cut short.
+    node.expires = std::max(now + to_ticks(delay) + 1, current_tick_);
+    node.period = period > Clock::duration::zero() ? std::max<uint64_t>(to_ticks(period), 1) : 0;
+    node.state = NodeState::ARMED;
+    node.cancelled = false;
+    link(index);
+    ++live_;
+
+    if (node.expires < wake_tick_) {
+        cv_.notify_one();
+    }
+    return TimerHandle{index, node.generation};
+}
+
+bool TimerWheel::cancel(TimerHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle.index >= nodes_.size()) {
+        return false;
+    }
+    Node& node = nodes_[handle.index];
+    if (node.generation != handle.generation) {
+        return false;
+    }
+    if (node.state == NodeState::ARMED) {
+        unlink(handle.index);
+        free_node(handle.index);
+        return true;
+    }
+    if (node.state == NodeState::FIRING && !node.cancelled) {
+        // The wheel thread frees it once the delivery returns.
+        node.cancelled = true;
+        return true;
+    }
+    return false;
+}
+
+size_t TimerWheel::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_;
+}
+
+uint32_t TimerWheel::allocate_node()
+{
+    if (free_head_ != NIL) {
+        uint32_t index = free_head_;
+        free_head_ = nodes_[index].next;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::free_node(uint32_t index)
+{
+    Node& node = nodes_[index];
+    node.message = ThreadWrapperMessage(); // Drop the payload now, not when the node is reused.
+    node.state = NodeState::FREE;
+    node.cancelled = false;
+    ++node.generation; // Outstanding handles go stale.
+    node.prev = NIL;
+    node.next = free_head_;
+    free_head_ = index;
+    --live_;
+}
+
+void TimerWheel::link(uint32_t index)
+{
+    Node& node = nodes_[index];
+    uint64_t delta = node.expires - current_tick_;
+    uint32_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    // Beyond the last level's range: park at its far end and re-cascade from there.
+    uint64_t expires = node.expires;
+    const uint64_t range = uint64_t(1) << (SLOT_BITS * LEVELS);
+    if (delta >= range) {
+        expires = current_tick_ + range - 1;
+    }
+
+    uint32_t slot = level * SLOTS + static_cast<uint32_t>((expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = heads_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[slot] = index;
+    ++level_counts_[level];
+}
+
+void TimerWheel::unlink(uint32_t index)
+{
+    Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    --level_counts_[node.slot / SLOTS];
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+}
+
+void TimerWheel::cascade(uint32_t level, uint32_t slot)
+{
+    uint32_t index = heads_[level * SLOTS + slot];
+    heads_[level * SLOTS + slot] = NIL;
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        --level_counts_[level];
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::expire_tick(std::vector<Due>& due)
+{
+    const uint64_t tick = current_tick_;
+    // Higher levels first, so a timer cascading down two levels is handled in one tick.
+    for (uint32_t level = LEVELS - 1; level > 0; --level) {
+        uint64_t mask = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+        if ((tick & mask) == 0) {
+            cascade(level, static_cast<uint32_t>((tick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+        }
+    }
+
+    uint32_t slot = static_cast<uint32_t>(tick & (SLOTS - 1));
+    uint32_t index = heads_[slot];
+    heads_[slot] = NIL;
+    while (index != NIL) {
+        Node& node = nodes_[index];
+        uint32_t next = node.next;
+        --level_counts_[0];
+        node.prev = NIL;
+        node.next = NIL;
+        node.slot = NIL;
+        node.state = NodeState::FIRING;
+        // One-shot timers hand over the payload; periodic ones keep it for the next round.
+        if (node.period == 0) {
+            due.push_back(Due{index, node.dest_id, std::move(node.message), ThreadWrapperError::OK});
+        } else {
+            due.push_back(Due{index, node.dest_id, node.message, ThreadWrapperError::OK});
+        }
+        index = next;
+    }
+    ++current_tick_;
+}
+
+void TimerWheel::rearm(uint32_t index)
+{
+    Node& node = nodes_[index];
+    node.expires += node.period;
+    if (node.expires < current_tick_) {
+        // Missed occurrences (the wheel thread was held up) are skipped, not replayed.
+        uint64_t behind = current_tick_ - node.expires;
+        node.expires += (behind + node.period - 1) / node.period * node.period;
+    }
+    node.state = NodeState::ARMED;
+    link(index);
+}
+
+void TimerWheel::deliver(std::vector<Due>& due, std::unique_lock<std::mutex>& lock)
+{
+    lock.unlock();
+    for (Due& item : due) {
+        ThreadWrapperMessage message = item.message; // Kept for a retry if the mailbox is full.
+        item.result = deliver_(item.dest_id, std::move(message));
+    }
+    lock.lock();
+
+    for (Due& item : due) {
+        Node& node = nodes_[item.index];
+        if (node.cancelled) {
+            free_node(item.index);
+        } else if (item.result == ThreadWrapperError::ENQUEUE_FAILED && node.period == 0) {
+            // Retry on the next tick rather than losing a one-shot message.
+            node.message = std::move(item.message);
+            node.expires = current_tick_;
+            node.state = NodeState::ARMED;
+            link(item.index);
+        } else if (item.result == ThreadWrapperError::OK || item.result == ThreadWrapperError::ENQUEUE_FAILED) {
+            if (node.period == 0) {
+                free_node(item.index);
+            } else {
+                rearm(item.index);
+            }
+        } else {
+            // The target has exited or been removed; that is a normal end for a
+            // timer its owner did not cancel, so drop it quietly.
+            free_node(item.index);
+        }
+    }
+    due.clear();
+}
+
+uint64_t TimerWheel::next_wake_tick() const
+{
+    if (live_ == 0) {
+        return UINT64_MAX;
+    }
+    if (level_counts_[0] > 0) {
+        return current_tick_;
+    }
+    // Only higher levels are populated: nothing can fire before the next cascade.
+    return (current_tick_ | (SLOTS - 1)) + 1;
+}
+
+void TimerWheel::run()
+{
+    std::vector<Due> due;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        uint64_t now = now_tick();
+        while (current_tick_ <= now && !stopping_) {
+            expire_tick(due);
+            if (!due.empty()) {
+                deliver(due, lock);
+            }
+        }
+
+        wake_tick_ = next_wake_tick();
+        if (wake_tick_ == UINT64_MAX) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_until(lock, start_ + TICK * wake_tick_);
+        }
+        wake_tick_ = UINT64_MAX;
+    }
+}
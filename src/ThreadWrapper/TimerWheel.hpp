@@ -0,0 +1,136 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadWrapper/ThreadWrapperError.hpp"
+#include "ThreadWrapper/ThreadWrapperMessage.hpp"
+
+/**
+ * @struct TimerHandle
+ * @brief Identifies a pending timer for cancellation. Default-constructed handles
+ * are invalid; a handle goes stale once its one-shot timer has fired.
+ */
+struct TimerHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool valid() const noexcept { return index != UINT32_MAX; }
+};
+
+/**
+ * @class TimerWheel
+ * @brief A hierarchical timing wheel on one thread, delivering delayed and periodic messages.
+ *
+ * Four levels of 256 slots at a 1 ms tick cover about 49 days; later
+ * deadlines are parked in the last level and re-cascaded. Adding and
+ * cancelling a timer is O(1): timers live in a slab and are linked into
+ * their slot by index. The thread wakes once per tick while timers are
+ * due within the first level, once per 256 ticks while they are further
+ * out, and sleeps indefinitely while there are none.
+ *
+ * Messages are handed to the `deliver` callback outside the wheel's lock.
+ * A one-shot message the destination cannot take yet (ENQUEUE_FAILED) is
+ * retried on the next tick; a periodic one skips that occurrence. Any other
+ * delivery error (destination gone) drops the timer.
+ */
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using DeliverFn = std::function<ThreadWrapperError(int dest_id, ThreadWrapperMessage message)>;
+
+    explicit TimerWheel(DeliverFn deliver);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Delivers `message` to `dest_id` after `delay`, and then every `period` if it is non-zero.
+     * Delays are rounded up to the next tick.
+     */
+    TimerHandle add(int dest_id, ThreadWrapperMessage message, Clock::duration delay,
+                    Clock::duration period = Clock::duration::zero());
+
+    /**
+     * @brief Cancels a timer: no further deliveries happen. A delivery already
+     * in progress on the wheel thread may still arrive.
+     * @return false if the handle is stale (one-shot already fired, or already cancelled).
+     */
+    bool cancel(TimerHandle handle);
+
+    /// @brief Number of live timers.
+    size_t pending() const;
+
+    static constexpr Clock::duration TICK = std::chrono::milliseconds(1);
+
+private:
+    static constexpr uint32_t LEVELS = 4;
+    static constexpr uint32_t SLOT_BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    enum class NodeState : uint8_t { FREE, ARMED, FIRING };
+
+    struct Node {
+        ThreadWrapperMessage message;
+        int dest_id = 0;
+        uint64_t expires = 0;       // In ticks.
+        uint64_t period = 0;        // In ticks; 0 for one-shot.
+        uint32_t prev = NIL;
+        uint32_t next = NIL;        // Also the free-list link.
+        uint32_t slot = NIL;        // level * SLOTS + index while ARMED.
+        uint32_t generation = 0;
+        NodeState state = NodeState::FREE;
+        bool cancelled = false;     // Cancelled while FIRING.
+    };
+
+    void run();
+    uint64_t now_tick() const;
+    uint64_t to_ticks(Clock::duration duration) const;
+
+    uint32_t allocate_node();
+    void free_node(uint32_t index);
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void cascade(uint32_t level, uint32_t slot);
+    void rearm(uint32_t index);
+    uint64_t next_wake_tick() const;
+
+    /// @brief A fired timer, copied out so it can be delivered without the lock.
+    struct Due {
+        uint32_t index;
+        int dest_id;
+        ThreadWrapperMessage message;
+        ThreadWrapperError result;
+    };
+
+    void expire_tick(std::vector<Due>& due);
+    void deliver(std::vector<Due>& due, std::unique_lock<std::mutex>& lock);
+
+    DeliverFn deliver_;
+    const Clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Node> nodes_;
+    uint32_t free_head_ = NIL;
+    uint32_t heads_[LEVELS * SLOTS];
+    uint32_t level_counts_[LEVELS] = {};
+    uint64_t current_tick_ = 0;        // Next tick to expire.
+    uint64_t wake_tick_ = UINT64_MAX;  // Tick the thread sleeps until.
+    size_t live_ = 0;                  // Armed or firing.
+    bool stopping_ = false;
+
+    std::thread thread_;
+};
+
+#endif // TIMER_WHEEL_HPP
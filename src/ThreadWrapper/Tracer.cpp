@@ -0,0 +1,263 @@
+#include "ThreadWrapper/Tracer.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+constexpr size_t RING_CAPACITY = 4096; // Records kept per thread; older ones are overwritten.
+
+// Stored as relaxed atomics so a dump may read a ring while its owner writes.
+// `sequence` is 2 * (index + 1) once record `index` is complete, odd while it is written.
+struct TraceRecord {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> timestamp_ns{0};
+    std::atomic<uint64_t> duration_ns{0};
+    std::atomic<uint64_t> trace{0};   // trace_id << 32 | hop << 8 | type
+    std::atomic<uint64_t> message{0}; // dest << 32 | msg_id
+};
+
+struct TraceRing {
+    explicit TraceRing(uint32_t id) : tid(id), records(RING_CAPACITY) {}
+
+    const uint32_t tid;
+    std::string name;                     // Guarded by g_rings_mutex.
+    std::atomic<uint64_t> head{0};        // Records ever written; only the owner stores.
+    std::atomic<uint64_t> cleared_below{0};
+    std::vector<TraceRecord> records;
+};
+
+struct PlainRecord {
+    uint64_t timestamp_ns;
+    uint64_t duration_ns;
+    uint32_t trace_id;
+    uint16_t hop;
+    TraceEventType type;
+    int dest;
+    int msg_id;
+};
+
+std::mutex g_rings_mutex;
+std::vector<std::shared_ptr<TraceRing>> g_rings; // Kept after their threads exit, for the dump.
+std::atomic<uint32_t> g_next_trace_id{1};
+
+thread_local std::shared_ptr<TraceRing> tls_ring;
+thread_local std::string tls_thread_name;
+thread_local uint32_t tls_sends = 0;
+
+TraceRing& current_ring()
+{
+    if (!tls_ring) {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        tls_ring = std::make_shared<TraceRing>(static_cast<uint32_t>(g_rings.size() + 1));
+        tls_ring->name = tls_thread_name.empty() ? "thread-" + std::to_string(tls_ring->tid) : tls_thread_name;
+        g_rings.push_back(tls_ring);
+    }
+    return *tls_ring;
+}
+
+// Copies the records of `ring` that are complete and not overwritten.
+void read_ring(const TraceRing& ring, std::vector<PlainRecord>& out)
+{
+    uint64_t end = ring.head.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+    begin = std::max(begin, ring.cleared_below.load(std::memory_order_relaxed));
+
+    for (uint64_t i = begin; i < end; ++i) {
+        const TraceRecord& record = ring.records[i % RING_CAPACITY];
+        const uint64_t expected = 2 * (i + 1);
+        if (record.sequence.load(std::memory_order_acquire) != expected) {
+            continue; // Already overwritten by the owner.
+        }
+        PlainRecord plain;
+        plain.timestamp_ns = record.timestamp_ns.load(std::memory_order_relaxed);
+        plain.duration_ns = record.duration_ns.load(std::memory_order_relaxed);
+        uint64_t trace = record.trace.load(std::memory_order_relaxed);
+        uint64_t message = record.message.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != expected) {
+            continue; // Overwritten while we read it.
+        }
+        plain.trace_id = static_cast<uint32_t>(trace >> 32);
+        plain.hop = static_cast<uint16_t>(trace >> 8);
+        plain.type = static_cast<TraceEventType>(trace & 0xff);
+        plain.dest = static_cast<int>(message >> 32);
+        plain.msg_id = static_cast<int>(static_cast<uint32_t>(message));
+        out.push_back(plain);
+    }
+}
+
+void write_json_string(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+}
+
+std::atomic<uint32_t> Tracer::sample_rate_{0};
+thread_local Tracer::Context Tracer::tls_context_;
+
+bool Tracer::assign_trace(ThreadWrapperMessage& message) noexcept
+{
+    if (tls_context_.trace_id != 0 && (message.trace_id == 0 || message.trace_id == tls_context_.trace_id)) {
+        // Sent (or an envelope forwarded) while handling a traced message: the next hop of the same trace.
+        message.trace_id = tls_context_.trace_id;
+        message.trace_hop = static_cast<uint16_t>(tls_context_.hop + 1);
+        return true;
+    }
+    if (message.trace_id != 0) {
+        return true;
+    }
+    uint32_t rate = sample_rate_.load(std::memory_order_relaxed);
+    if (rate == 0 || tls_sends++ % rate != 0) {
+        return false;
+    }
+    uint32_t id = g_next_trace_id.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) {
+        id = g_next_trace_id.fetch_add(1, std::memory_order_relaxed); // 0 means "not traced".
+    }
+    message.trace_id = id;
+    message.trace_hop = 0;
+    return true;
+}
+
+void Tracer::record(TraceEventType type, const TraceTag& tag,
+                    uint64_t timestamp_ns, uint64_t duration_ns) noexcept
+{
+    TraceRing& ring = current_ring();
+    uint64_t index = ring.head.load(std::memory_order_relaxed);
+    TraceRecord& record = ring.records[index % RING_CAPACITY];
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+    record.duration_ns.store(duration_ns, std::memory_order_relaxed);
+    record.trace.store(static_cast<uint64_t>(tag.trace_id) << 32 |
+                       static_cast<uint64_t>(tag.hop) << 8 |
+                       static_cast<uint64_t>(type),
+                       std::memory_order_relaxed);
+    record.message.store(static_cast<uint64_t>(static_cast<uint32_t>(tag.dest)) << 32 |
+                         static_cast<uint32_t>(tag.msg_id),
+                         std::memory_order_relaxed);
+    record.sequence.store(2 * (index + 1), std::memory_order_release);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::set_thread_name(const std::string& name)
+{
+    tls_thread_name = name;
+    if (tls_ring) {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        tls_ring->name = name;
+    }
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    for (auto& ring : g_rings) {
+        ring->cleared_below.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+void Tracer::dump_chrome_trace(std::ostream& out)
+{
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        rings = g_rings;
+        for (const auto& ring : rings) {
+            names.push_back(ring->name);
+        }
+    }
+
+    char line[256];
+    bool first = true;
+    auto begin_event = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    std::vector<PlainRecord> records;
+    for (size_t r = 0; r < rings.size(); ++r) {
+        const uint32_t tid = rings[r]->tid;
+        begin_event();
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid << ", \"args\": {\"name\": ";
+        write_json_string(out, names[r]);
+        out << "}}";
+
+        records.clear();
+        read_ring(*rings[r], records);
+        for (const PlainRecord& record : records) {
+            // One flow arrow and one async "queue" span per hop, keyed by trace and hop.
+            const uint64_t hop_id = static_cast<uint64_t>(record.trace_id) << 16 | record.hop;
+            const double ts_us = static_cast<double>(record.timestamp_ns) / 1000.0;
+            switch (record.type) {
+                case TraceEventType::ENQUEUE:
+                    begin_event();
+                    snprintf(line, sizeof(line),
+                             "{\"name\": \"queue\", \"cat\": \"queue\", \"ph\": \"b\", \"id\": %" PRIu64
+                             ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"trace_id\": %u, \"hop\": %u, "
+                             "\"dest\": %d, \"msg_id\": %d}}",
+                             hop_id, ts_us, tid, record.trace_id, record.hop, record.dest, record.msg_id);
+                    out << line;
+                    begin_event();
+                    snprintf(line, sizeof(line),
+                             "{\"name\": \"hop\", \"cat\": \"flow\", \"ph\": \"s\", \"id\": %" PRIu64
+                             ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+                             hop_id, ts_us, tid);
+                    out << line;
+                    break;
+                case TraceEventType::DEQUEUE:
+                    begin_event();
+                    snprintf(line, sizeof(line),
+                             "{\"name\": \"queue\", \"cat\": \"queue\", \"ph\": \"e\", \"id\": %" PRIu64
+                             ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+                             hop_id, ts_us, tid);
+                    out << line;
+                    begin_event();
+                    snprintf(line, sizeof(line),
+                             "{\"name\": \"hop\", \"cat\": \"flow\", \"ph\": \"f\", \"bp\": \"e\", \"id\": %" PRIu64
+                             ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+                             hop_id, ts_us, tid);
+                    out << line;
+                    break;
+                case TraceEventType::PROCESS:
+                    begin_event();
+                    snprintf(line, sizeof(line),
+                             "{\"name\": \"msg %d\", \"cat\": \"process\", \"ph\": \"X\", \"ts\": %.3f, "
+                             "\"dur\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"trace_id\": %u, \"hop\": %u, "
+                             "\"dest\": %d}}",
+                             record.msg_id, ts_us, static_cast<double>(record.duration_ns) / 1000.0, tid,
+                             record.trace_id, record.hop, record.dest);
+                    out << line;
+                    break;
+            }
+        }
+    }
+    out << "\n]}\n";
+}
+
+bool Tracer::dump_chrome_trace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    dump_chrome_trace(file);
+    return static_cast<bool>(file);
+}
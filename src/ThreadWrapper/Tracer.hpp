@@ -0,0 +1,128 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "ThreadWrapper/ThreadWrapperMessage.hpp"
+
+/**
+ * @enum TraceEventType
+ * @brief What a trace record marks on one hop of a traced message.
+ */
+enum class TraceEventType : uint8_t {
+    ENQUEUE,  // Pushed into the destination's mailbox (recorded by the sender).
+    DEQUEUE,  // Taken out of the mailbox (recorded by the consumer).
+    PROCESS,  // Handled by process_batch(); carries a duration.
+};
+
+/**
+ * @struct TraceTag
+ * @brief What a trace record identifies a message by; small enough to keep
+ * while the envelope itself has been moved on.
+ */
+struct TraceTag {
+    uint32_t trace_id = 0;
+    uint16_t hop = 0;
+    int dest = 0;
+    int msg_id = 0;
+
+    static TraceTag of(const ThreadWrapperMessage& message) noexcept
+    {
+        return TraceTag{message.trace_id, message.trace_hop, message.dest, message.msg_id};
+    }
+};
+
+/**
+ * @class Tracer
+ * @brief Sampled end-to-end message tracing with Chrome trace_event export.
+ *
+ * One send in `sample_rate` (per sending thread) that is not already part
+ * of a trace starts a new one: the envelope gets a trace ID and a hop
+ * number. Whatever a handler sends while it processes a traced message
+ * joins the same trace with the next hop, so a message can be followed
+ * through a whole pipeline. Enqueue, dequeue and processing times are
+ * written to a fixed-size ring per OS thread (single writer, no locks) and
+ * only merged when dump_chrome_trace() is called; old records are
+ * overwritten once a ring is full.
+ *
+ * With sampling off (the default) the cost per send is a thread-local read
+ * and one relaxed load, and per dequeued message a test of trace_id.
+ */
+class Tracer
+{
+    struct Context {
+        uint32_t trace_id = 0;
+        uint16_t hop = 0;
+    };
+
+public:
+    /// @brief Trace one in `one_in_n` new sends per thread; 0 turns sampling off.
+    static void set_sample_rate(uint32_t one_in_n) noexcept
+    {
+        sample_rate_.store(one_in_n, std::memory_order_relaxed);
+    }
+    static uint32_t sample_rate() noexcept { return sample_rate_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Send-side hook: propagates the current trace into `message`, or samples a new one.
+     * @return true if the message is traced, with `tag` filled in for the caller's ENQUEUE record.
+     */
+    static bool on_send(ThreadWrapperMessage& message, TraceTag& tag) noexcept
+    {
+        if (message.trace_id == 0 && tls_context_.trace_id == 0 &&
+            sample_rate_.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        if (!assign_trace(message)) {
+            return false;
+        }
+        tag = TraceTag::of(message);
+        return true;
+    }
+
+    /// @brief Appends a record to the calling thread's ring.
+    static void record(TraceEventType type, const TraceTag& tag,
+                       uint64_t timestamp_ns, uint64_t duration_ns = 0) noexcept;
+
+    /**
+     * @class Scope
+     * @brief Makes a traced message the current trace while it is processed, so sends join it.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const TraceTag& tag) noexcept : saved_(tls_context_)
+        {
+            tls_context_ = Context{tag.trace_id, tag.hop};
+        }
+        ~Scope() { tls_context_ = saved_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Context saved_;
+    };
+
+    /// @brief Names the calling thread in the exported trace (defaults to "thread-<n>").
+    static void set_thread_name(const std::string& name);
+
+    /// @brief Writes everything recorded so far as Chrome trace_event JSON (chrome://tracing, Perfetto).
+    static void dump_chrome_trace(std::ostream& out);
+    /// @brief Same, to a file. @return false if the file cannot be written.
+    static bool dump_chrome_trace(const std::string& path);
+
+    /// @brief Forgets the records made so far.
+    static void clear();
+
+private:
+    static bool assign_trace(ThreadWrapperMessage& message) noexcept;
+
+    static std::atomic<uint32_t> sample_rate_;
+    static thread_local Context tls_context_;
+};
+
+#endif // TRACER_HPP
@@ -0,0 +1,134 @@
+#ifndef WORK_STEALING_DEQUE_HPP
+#define WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "ThreadWrapper/LockFreeQueue.hpp" // CACHE_LINE_SIZE
+
+/**
+ * @class WorkStealingDeque
+ * @brief Chase-Lev work-stealing deque (with the C11 orderings of Lê et al.).
+ *
+ * The owner pushes and pops at the bottom without any RMW in the common
+ * case; other threads steal from the top with a CAS. The buffer grows when
+ * full. Outgrown buffers are kept until the deque is destroyed because a
+ * thief may still be reading one, which bounds the waste to the final size.
+ *
+ * T must be trivially copyable (the executor stores plain pointers).
+ */
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque stores trivially copyable values");
+
+public:
+    explicit WorkStealingDeque(uint32_t initial_capacity = 64)
+    {
+        uint32_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity <<= 1;
+        }
+        buffers_.push_back(std::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /// @brief Pushes at the bottom. Owner only.
+    void push(T value)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(buffer->mask)) {
+            buffer = grow(buffer, top, bottom);
+        }
+        buffer->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// @brief Pops from the bottom (LIFO). Owner only. @return false if empty.
+    bool pop(T& value)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = buffer->get(bottom);
+        if (top == bottom) {
+            // Last item: race the thieves for it.
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /// @brief Steals from the top (FIFO). Any thread. @return false if empty or if it lost a race.
+    bool steal(T& value)
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        T candidate = buffer->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        value = candidate;
+        return true;
+    }
+
+    /// @brief Checks if the deque is empty. Approximate while other threads push or steal.
+    bool empty() const
+    {
+        int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_seq_cst);
+        return bottom <= top;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(uint32_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        T get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+        void put(int64_t index, T value) { slots[index & mask].store(value, std::memory_order_relaxed); }
+
+        const uint64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Buffer* grow(Buffer* old_buffer, int64_t top, int64_t bottom)
+    {
+        buffers_.push_back(std::make_unique<Buffer>(static_cast<uint32_t>((old_buffer->mask + 1) * 2)));
+        Buffer* buffer = buffers_.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            buffer->put(i, old_buffer->get(i));
+        }
+        buffer_.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_; // Owner only.
+};
+
+#endif // WORK_STEALING_DEQUE_HPP
@@ -14,6 +14,15 @@
 // ====================================================================
 // *** FIX: Define helper function BEFORE main so it's declared. ***
 // ====================================================================
+void print_metrics(const ThreadMetricsSnapshot& metrics) {
+    std::cout << std::setw(12) << metrics.messages_processed
+              << std::setw(8) << metrics.peak_queue_depth
+              << std::setw(8) << std::fixed << std::setprecision(1) << metrics.busy_ratio() * 100.0
+              << std::setw(12) << std::setprecision(2) << metrics.process_time.percentile(0.99) / 1000.0
+              << std::setw(12) << metrics.queue_wait.percentile(0.99) / 1000.0 << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+}
+
 void print_task_details(const std::vector<TaskDetails>& all_tasks) {
     std::cout << "\n====================== TASK STATUS REPORT ======================\n";
     if (all_tasks.empty()) {
@@ -24,18 +33,61 @@ void print_task_details(const std::vector<TaskDetails>& all_tasks) {
         std::cout << "    " << std::left << std::setw(20) << "Thread Name"
                   << std::setw(15) << "Status"
                   << std::setw(15) << "Queue Size"
-                  << std::setw(15) << "Ref Count" << "\n";
-        std::cout << "    " << std::string(60, '-') << "\n";
+                  << std::setw(15) << "Ref Count"
+                  << std::setw(8) << "CPU"
+                  << std::setw(8) << "Node"
+                  << std::setw(12) << "Processed"
+                  << std::setw(8) << "PeakQ"
+                  << std::setw(8) << "Busy%"
+                  << std::setw(12) << "Proc99(us)"
+                  << std::setw(12) << "Wait99(us)" << "\n";
+        std::cout << "    " << std::string(128, '-') << "\n";
         for (const auto& thread : task.threads) {
             std::cout << "    " << std::left << std::setw(20) << thread.name
                       << std::setw(15) << status_to_string(thread.status)
                       << std::setw(15) << thread.queue_size
-                      << std::setw(15) << thread.reference_count << "\n";
+                      << std::setw(15) << thread.reference_count
+                      << std::setw(8) << thread.cpu
+                      << std::setw(8) << thread.numa_node;
+            print_metrics(thread.metrics);
+            for (const auto& replica : thread.replicas) {
+                std::cout << "      " << std::left << std::setw(18) << replica.name
+                          << std::setw(15) << status_to_string(replica.status)
+                          << std::setw(15) << replica.queue_size
+                          << std::setw(15) << ""
+                          << std::setw(8) << replica.cpu
+                          << std::setw(8) << replica.numa_node;
+                print_metrics(replica.metrics);
+            }
         }
     }
     std::cout << "================================================================\n";
 }
 
+// Stops a slow stage holding 40 queued messages: drain() when drain_timeout is zero, otherwise drain_for().
+bool drain_backlog(TaskManager& task_manager, const std::string& task_name, std::chrono::milliseconds drain_timeout) {
+    std::cout << "\n--- Stopping a backlog of 40 with "
+              << (drain_timeout.count() == 0 ? std::string("drain()")
+                                             : "drain_for(" + std::to_string(drain_timeout.count()) + "ms)")
+              << " ---" << std::endl;
+    const std::string stage_name = "Slow-" + task_name;
+    std::vector<ThreadWrapperParam> params;
+    params.push_back({std::make_unique<ProcessorThread>(std::chrono::milliseconds(2)), stage_name});
+    if (!task_manager.create_task(task_name, params)) {
+        std::cerr << "Failed to create " << task_name << std::endl;
+        return false;
+    }
+    const int stage_id = get_thread_wrapper_id_by_name(stage_name);
+    for (int i = 0; i < 40; ++i) {
+        send_message(stage_id, static_cast<int>(MessageId::PROCESS_PIPELINE_MSG), std::make_shared<PipelineMessage>());
+    }
+    StopReport report;
+    task_manager.stop_task(task_name, drain_timeout.count() == 0 ? StopMode::drain() : StopMode::drain_for(drain_timeout),
+                           &report);
+    std::cout << "Processed " << report.processed << ", discarded " << report.discarded << std::endl;
+    return true;
+}
+
 int main() {
     auto& task_manager = get_task_manager_instance();
 
@@ -60,7 +112,23 @@ int main() {
         return -1;
     }
     
-    std::cout << "\n--- Both tasks running for 2 seconds ---" << std::endl;
+    // --- Task C is declared as a graph: two producers fan in to a processor, which feeds a consumer ---
+    std::cout << "\n--- Creating Task C (pipeline graph) ---" << std::endl;
+    PipelineGraph graph;
+    graph.add_stage({std::make_unique<ProducerThread>(std::vector<std::string>{}), "Producer-C1"})
+         .add_stage({std::make_unique<ProducerThread>(std::vector<std::string>{}), "Producer-C2"})
+         .add_stage({std::make_unique<ProcessorThread>(), "Processor-C"})
+         .add_stage({std::make_unique<ConsumerThread>(result_queue), "Consumer-C"})
+         .fan_in({"Producer-C1", "Producer-C2"}, "Processor-C")
+         .chain({"Processor-C", "Consumer-C"});
+    if (!task_manager.create_pipeline("TaskC", graph)) {
+        std::cerr << "Failed to create Task C" << std::endl;
+        return -1;
+    }
+    send_message(get_thread_wrapper_id_by_name("Producer-C1"), static_cast<int>(MessageId::APP_START), nullptr);
+    send_message(get_thread_wrapper_id_by_name("Producer-C2"), static_cast<int>(MessageId::APP_START), nullptr);
+
+    std::cout << "\n--- All tasks running for 2 seconds ---" << std::endl;
     std::this_thread::sleep_for(std::chrono::seconds(2));
 
     // DEMO: Query and print details for a SINGLE task before stopping it.
@@ -87,6 +155,37 @@ int main() {
     std::cout << "\n--- Stopping Task B ---" << std::endl;
     task_manager.stop_task("TaskB");
 
+    std::cout << "\n--- Stopping Task C ---" << std::endl;
+    task_manager.stop_task("TaskC");
+
+    // DEMO: A slow stage with a backlog, stopped two ways. drain() finishes every
+    // queued message; drain_for() gives up at its deadline and reports the rest.
+    if (!drain_backlog(task_manager, "TaskD", std::chrono::milliseconds(0)) ||
+        !drain_backlog(task_manager, "TaskE", std::chrono::milliseconds(20))) {
+        return -1;
+    }
+
+    // DEMO: A stage whose initialize() overruns the start deadline. create_task() gives up
+    // at the deadline instead of waiting it out, and the names are free to retry at once.
+    std::cout << "\n--- Creating Task F with a 50ms init timeout (init takes 300ms) ---" << std::endl;
+    std::vector<ThreadWrapperParam> late_params;
+    late_params.push_back({std::make_unique<ProcessorThread>(std::chrono::milliseconds(0), std::chrono::milliseconds(300)),
+                           "Slow-Init-F"});
+    const auto create_begin = std::chrono::steady_clock::now();
+    const bool created = task_manager.create_task("TaskF", late_params, std::chrono::milliseconds(50));
+    std::cout << "create_task returned " << (created ? "true" : "false") << " after "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - create_begin).count()
+              << "ms" << std::endl;
+
+    std::cout << "\n--- Re-creating Task F with the same names ---" << std::endl;
+    std::vector<ThreadWrapperParam> retry_params;
+    retry_params.push_back({std::make_unique<ProcessorThread>(), "Slow-Init-F"});
+    if (!task_manager.create_task("TaskF", retry_params, std::chrono::milliseconds(50))) {
+        std::cerr << "Failed to re-create Task F" << std::endl;
+        return -1;
+    }
+    task_manager.stop_task("TaskF");
+
     std::cout << "\n--- Application exiting ---" << std::endl;
     return 0;
 }
\ No newline at end of file